@@ -0,0 +1,253 @@
+#include "AffineFrame.h"
+
+#include "Frame.h"
+#include "MyMath/MyMath.h"
+
+#include <cassert>
+
+using namespace DirectX;
+
+static_assert(sizeof(Dxx::AffineFrame) == 48, "AffineFrame must be 48 bytes");
+
+namespace
+{
+// Row j of the transposed matrix is column j of the transformation matrix, so the translation is in the W components
+// and the constant column is not stored at all.
+
+void LoadRows(XMFLOAT3X4A const & m, XMVECTOR & r0, XMVECTOR & r1, XMVECTOR & r2)
+{
+    r0 = XMLoadFloat4A(reinterpret_cast<XMFLOAT4A const *>(m.m[0]));
+    r1 = XMLoadFloat4A(reinterpret_cast<XMFLOAT4A const *>(m.m[1]));
+    r2 = XMLoadFloat4A(reinterpret_cast<XMFLOAT4A const *>(m.m[2]));
+}
+
+void StoreRows(XMFLOAT3X4A & m, FXMVECTOR r0, FXMVECTOR r1, FXMVECTOR r2)
+{
+    XMStoreFloat4A(reinterpret_cast<XMFLOAT4A *>(m.m[0]), r0);
+    XMStoreFloat4A(reinterpret_cast<XMFLOAT4A *>(m.m[1]), r1);
+    XMStoreFloat4A(reinterpret_cast<XMFLOAT4A *>(m.m[2]), r2);
+}
+
+// Returns column j of A * B, given column j of B and the first three columns of A
+XMVECTOR ComposeColumn(FXMVECTOR b, FXMVECTOR a0, FXMVECTOR a1, GXMVECTOR a2)
+{
+    // The W component of B's column is the translation, which is added (A's constant column is (0, 0, 0, 1))
+    XMVECTOR c = XMVectorMultiply(b, g_XMIdentityR3);
+    c = XMVectorMultiplyAdd(XMVectorSplatX(b), a0, c);
+    c = XMVectorMultiplyAdd(XMVectorSplatY(b), a1, c);
+    c = XMVectorMultiplyAdd(XMVectorSplatZ(b), a2, c);
+    return c;
+}
+} // anonymous namespace
+
+namespace Dxx
+{
+//! The frame's transformation is computed as M = S * R * T
+//!
+//! @param	translation		Translation component as a 3D vector
+//! @param	rotation		Rotation component as a quaternion
+//! @param	scale			Scale component as a 3D vector
+
+AffineFrame::AffineFrame(XMFLOAT3 const & translation,
+                         XMFLOAT4 const & rotation,
+                         XMFLOAT3 const & scale /* = XMFLOAT3( 1.0f, 1.0f, 1.0f )*/)
+{
+    XMMATRIX m_simd = XMMatrixRotationQuaternion(XMLoadFloat4(&rotation));
+    m_simd.r[0] = m_simd.r[0] * XMVectorReplicate(scale.x);
+    m_simd.r[1] = m_simd.r[1] * XMVectorReplicate(scale.y);
+    m_simd.r[2] = m_simd.r[2] * XMVectorReplicate(scale.z);
+    m_simd.r[3] = XMVectorSet(translation.x, translation.y, translation.z, 1.0f);
+
+    XMStoreFloat3x4A(&m_, m_simd);
+}
+
+//! @param	m	Transformation matrix
+
+AffineFrame::AffineFrame(XMFLOAT4X4 const & m)
+{
+    XMStoreFloat3x4A(&m_, XMLoadFloat4x4(&m));
+}
+
+//! @param	frame	Frame to convert
+
+AffineFrame::AffineFrame(Frame const & frame)
+{
+    XMFLOAT4X4 m = frame.transformation();
+    XMStoreFloat3x4A(&m_, XMLoadFloat4x4(&m));
+}
+
+//! M' =  T * M
+//!
+//! @param	t	translation (in local space)
+
+AffineFrame & AffineFrame::translate(XMFLOAT3 const & t)
+{
+    // Only the translation changes, by t * M, which is the dot product of t with each column
+    XMVECTOR r0;
+    XMVECTOR r1;
+    XMVECTOR r2;
+    LoadRows(m_, r0, r1, r2);
+
+    XMVECTOR t_simd = XMLoadFloat3(&t);
+    r0 = XMVectorMultiplyAdd(XMVector3Dot(t_simd, r0), g_XMIdentityR3, r0);
+    r1 = XMVectorMultiplyAdd(XMVector3Dot(t_simd, r1), g_XMIdentityR3, r1);
+    r2 = XMVectorMultiplyAdd(XMVector3Dot(t_simd, r2), g_XMIdentityR3, r2);
+
+    StoreRows(m_, r0, r1, r2);
+    return *this;
+}
+
+//! M' = R * M
+//!
+//! @param	r	rotation (in local space)
+
+AffineFrame & AffineFrame::rotate(XMFLOAT4 const & r)
+{
+    XMVECTOR r0;
+    XMVECTOR r1;
+    XMVECTOR r2;
+    LoadRows(m_, r0, r1, r2);
+
+    // The columns of R
+    XMMATRIX a_simd = XMMatrixTranspose(XMMatrixRotationQuaternion(XMLoadFloat4(&r)));
+
+    StoreRows(m_,
+              ComposeColumn(r0, a_simd.r[0], a_simd.r[1], a_simd.r[2]),
+              ComposeColumn(r1, a_simd.r[0], a_simd.r[1], a_simd.r[2]),
+              ComposeColumn(r2, a_simd.r[0], a_simd.r[1], a_simd.r[2]));
+    return *this;
+}
+
+//! M' = S * M
+//!
+//! @param	s	scale (in local space)
+
+AffineFrame & AffineFrame::scale(XMFLOAT3 const & s)
+{
+    assert(!MyMath::IsCloseToZero(s.x));
+    assert(!MyMath::IsCloseToZero(s.y));
+    assert(!MyMath::IsCloseToZero(s.z));
+
+    // Each row of M is scaled, so the first three components of each column are scaled
+    XMVECTOR r0;
+    XMVECTOR r1;
+    XMVECTOR r2;
+    LoadRows(m_, r0, r1, r2);
+
+    XMVECTOR s_simd = XMVectorSet(s.x, s.y, s.z, 1.0f);
+    StoreRows(m_, r0 * s_simd, r1 * s_simd, r2 * s_simd);
+    return *this;
+}
+
+//!
+//! @param	t	translation
+
+void AffineFrame::setTranslation(XMFLOAT3 const & t)
+{
+    m_._14 = t.x;
+    m_._24 = t.y;
+    m_._34 = t.z;
+}
+
+//!
+//! @param	m	Value to set the transformation matrix to.
+
+void AffineFrame::setTransformation(XMFLOAT4X4 const & m)
+{
+    XMStoreFloat3x4A(&m_, XMLoadFloat4x4(&m));
+}
+
+XMFLOAT4X4 AffineFrame::transformation() const
+{
+    XMFLOAT4X4 m;
+    XMStoreFloat4x4(&m, XMLoadFloat3x4A(&m_));
+    return m;
+}
+
+//! The inverse of [ L 0 ; t 1 ] is [ L^-1 0 ; -t * L^-1 1 ], so only the 3x3 part is inverted.
+
+AffineFrame AffineFrame::inverse() const
+{
+    XMVECTOR r0;
+    XMVECTOR r1;
+    XMVECTOR r2;
+    LoadRows(m_, r0, r1, r2);
+
+    // Transposing gives the rows of L and the translation (with 0 in their W components)
+    XMMATRIX m_simd = XMMatrixTranspose(XMMATRIX(r0, r1, r2, XMVectorZero()));
+
+    // The columns of the inverse of L are the cross products of its rows, divided by the determinant
+    XMVECTOR c0  = XMVector3Cross(m_simd.r[1], m_simd.r[2]);
+    XMVECTOR c1  = XMVector3Cross(m_simd.r[2], m_simd.r[0]);
+    XMVECTOR c2  = XMVector3Cross(m_simd.r[0], m_simd.r[1]);
+    XMVECTOR det = XMVector3Dot(m_simd.r[0], c0);
+    assert(!MyMath::IsCloseToZero(XMVectorGetX(det)));
+
+    XMVECTOR reciprocal = XMVectorReciprocal(det);
+    c0 = c0 * reciprocal;
+    c1 = c1 * reciprocal;
+    c2 = c2 * reciprocal;
+
+    // The inverse's translation is -t * L^-1, which is the dot product of -t with each column
+    XMVECTOR t_simd = XMVectorNegate(m_simd.r[3]);
+
+    AffineFrame result;
+    StoreRows(result.m_,
+              XMVectorSelect(XMVector3Dot(t_simd, c0), c0, g_XMSelect1110),
+              XMVectorSelect(XMVector3Dot(t_simd, c1), c1, g_XMSelect1110),
+              XMVectorSelect(XMVector3Dot(t_simd, c2), c2, g_XMSelect1110));
+    return result;
+}
+
+//! @param	p	Point to transform
+
+XMFLOAT3 AffineFrame::transformPoint(XMFLOAT3 const & p) const
+{
+    XMVECTOR r0;
+    XMVECTOR r1;
+    XMVECTOR r2;
+    LoadRows(m_, r0, r1, r2);
+
+    XMVECTOR p_simd = XMVectorSet(p.x, p.y, p.z, 1.0f);
+    return XMFLOAT3(XMVectorGetX(XMVector4Dot(p_simd, r0)),
+                    XMVectorGetX(XMVector4Dot(p_simd, r1)),
+                    XMVectorGetX(XMVector4Dot(p_simd, r2)));
+}
+
+//! @param	v	Direction to transform
+
+XMFLOAT3 AffineFrame::transformVector(XMFLOAT3 const & v) const
+{
+    XMVECTOR r0;
+    XMVECTOR r1;
+    XMVECTOR r2;
+    LoadRows(m_, r0, r1, r2);
+
+    XMVECTOR v_simd = XMLoadFloat3(&v);
+    return XMFLOAT3(XMVectorGetX(XMVector3Dot(v_simd, r0)),
+                    XMVectorGetX(XMVector3Dot(v_simd, r1)),
+                    XMVectorGetX(XMVector3Dot(v_simd, r2)));
+}
+
+//! The result's transformation is A * B.
+//!
+//! @param	a	The first frame
+//! @param	b	The second frame
+
+AffineFrame AffineFrame::compose(AffineFrame const & a, AffineFrame const & b)
+{
+    XMVECTOR a0;
+    XMVECTOR a1;
+    XMVECTOR a2;
+    LoadRows(a.m_, a0, a1, a2);
+
+    XMVECTOR b0;
+    XMVECTOR b1;
+    XMVECTOR b2;
+    LoadRows(b.m_, b0, b1, b2);
+
+    AffineFrame result;
+    StoreRows(result.m_, ComposeColumn(b0, a0, a1, a2), ComposeColumn(b1, a0, a1, a2), ComposeColumn(b2, a0, a1, a2));
+    return result;
+}
+} // namespace Dxx
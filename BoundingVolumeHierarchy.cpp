@@ -0,0 +1,392 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+int constexpr NUM_BINS = 12;       // Number of bins used to evaluate the surface area heuristic
+uint8_t constexpr NO_PLANE = 0xff; // Indicates that a node was not rejected by any plane
+
+// An axis-aligned box used while building
+struct Aabb
+{
+    Aabb()
+        : min{ FLT_MAX, FLT_MAX, FLT_MAX }
+        , max{ -FLT_MAX, -FLT_MAX, -FLT_MAX }
+    {
+    }
+
+    void grow(XMFLOAT3 const & lo, XMFLOAT3 const & hi)
+    {
+        min[0] = std::min(min[0], lo.x);
+        min[1] = std::min(min[1], lo.y);
+        min[2] = std::min(min[2], lo.z);
+        max[0] = std::max(max[0], hi.x);
+        max[1] = std::max(max[1], hi.y);
+        max[2] = std::max(max[2], hi.z);
+    }
+
+    void grow(Aabb const & b)
+    {
+        grow(XMFLOAT3(b.min[0], b.min[1], b.min[2]), XMFLOAT3(b.max[0], b.max[1], b.max[2]));
+    }
+
+    bool isEmpty() const { return min[0] > max[0]; }
+
+    float area() const
+    {
+        if (isEmpty())
+            return 0.0f;
+        float dx = max[0] - min[0];
+        float dy = max[1] - min[1];
+        float dz = max[2] - min[2];
+        return 2.0f * (dx * dy + dy * dz + dz * dx);
+    }
+
+    float min[3];
+    float max[3];
+};
+
+float Component(XMFLOAT3 const & v, int axis)
+{
+    return (&v.x)[axis];
+}
+
+// Appends a range, merging it with the previous range if they are adjacent
+void AppendRange(std::vector<Dxx::BoundingVolumeHierarchy::Range> & ranges, uint32_t first, uint32_t count)
+{
+    if (!ranges.empty() && ranges.back().first + ranges.back().count == first)
+        ranges.back().count += count;
+    else
+        ranges.push_back({ first, count });
+}
+} // anonymous namespace
+
+namespace Dxx
+{
+//! @param	boxes			Bounds of the objects
+//! @param	maxLeafSize		Maximum number of objects in a leaf
+
+void BoundingVolumeHierarchy::build(BoxBounds const & boxes, int maxLeafSize /* = 4 */)
+{
+    assert(maxLeafSize > 0);
+
+    maxLeafSize_ = maxLeafSize;
+    nodes_.clear();
+    indexes_.resize(boxes.count);
+    boxMin_.resize(boxes.count);
+    boxMax_.resize(boxes.count);
+    centroids_.resize(boxes.count);
+
+    for (size_t i = 0; i < boxes.count; ++i)
+    {
+        indexes_[i]   = uint32_t(i);
+        boxMin_[i]    = XMFLOAT3(boxes.minX[i], boxes.minY[i], boxes.minZ[i]);
+        boxMax_[i]    = XMFLOAT3(boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i]);
+        centroids_[i] = XMFLOAT3((boxMin_[i].x + boxMax_[i].x) * 0.5f,
+                                 (boxMin_[i].y + boxMax_[i].y) * 0.5f,
+                                 (boxMin_[i].z + boxMax_[i].z) * 0.5f);
+    }
+
+    if (boxes.count > 0)
+    {
+        nodes_.reserve(2 * boxes.count / maxLeafSize + 1);
+        Build(0, uint32_t(boxes.count));
+    }
+    lastPlanes_.assign(nodes_.size(), NO_PLANE);
+
+    // The build data is no longer needed
+
+    boxMin_    = std::vector<XMFLOAT3>();
+    boxMax_    = std::vector<XMFLOAT3>();
+    centroids_ = std::vector<XMFLOAT3>();
+}
+
+//! The structure of the hierarchy is unchanged, and the bounds of every node are recomputed from the new bounds of its
+//! objects.
+//!
+//! @param	boxes	New bounds of the objects. The number and order of the objects must be the same as when the
+//!					hierarchy was built.
+
+void BoundingVolumeHierarchy::refit(BoxBounds const & boxes)
+{
+    assert(boxes.count == indexes_.size());
+
+    // Children always follow their parents, so the nodes are updated in reverse order.
+
+    for (size_t i = nodes_.size(); i-- > 0;)
+    {
+        Node & node = nodes_[i];
+        Aabb   bounds;
+        if (node.right == 0)
+        {
+            for (uint32_t j = node.first; j < node.first + node.count; ++j)
+            {
+                uint32_t k = indexes_[j];
+                bounds.grow(XMFLOAT3(boxes.minX[k], boxes.minY[k], boxes.minZ[k]),
+                            XMFLOAT3(boxes.maxX[k], boxes.maxY[k], boxes.maxZ[k]));
+            }
+        }
+        else
+        {
+            Node const & left  = nodes_[i + 1];
+            Node const & right = nodes_[node.right];
+            bounds.grow(left.min, left.max);
+            bounds.grow(right.min, right.max);
+        }
+        node.min = XMFLOAT3(bounds.min[0], bounds.min[1], bounds.min[2]);
+        node.max = XMFLOAT3(bounds.max[0], bounds.max[1], bounds.max[2]);
+    }
+}
+
+//! Planes that a node is completely inside of are not tested for any of the node's descendants, and once a node is
+//! completely inside all of the planes, its entire subtree is reported without further testing. Adjacent ranges are
+//! merged.
+//!
+//! @param	frustum		Culling volume
+//! @param	visible		Ranges of entries in objectIndexes() that are at least partially inside are appended to this
+//! @param	pStats		If not nullptr, the counts of the work done are stored here
+
+void BoundingVolumeHierarchy::cull(CullingFrustum const & frustum,
+                                   std::vector<Range> &   visible,
+                                   CullStats *            pStats /* = nullptr */) const
+{
+    Cull(frustum, visible, nullptr, pStats);
+}
+
+//! This is the same as cull(), except that the index of the plane that last rejected each node is saved, and that
+//! plane is tested first the next time. Between frames, the culling volume usually changes very little, so a node
+//! that was rejected by a plane is usually rejected by the same plane again.
+//!
+//! @param	frustum		Culling volume
+//! @param	visible		Ranges of entries in objectIndexes() that are at least partially inside are appended to this
+//! @param	pStats		If not nullptr, the counts of the work done are stored here
+
+void BoundingVolumeHierarchy::cullCoherent(CullingFrustum const & frustum,
+                                           std::vector<Range> &   visible,
+                                           CullStats *            pStats /* = nullptr */)
+{
+    Cull(frustum, visible, lastPlanes_.data(), pStats);
+}
+
+uint32_t BoundingVolumeHierarchy::Build(uint32_t first, uint32_t count)
+{
+    uint32_t index = uint32_t(nodes_.size());
+    nodes_.emplace_back();
+
+    // Compute the bounds of the objects and of their centroids
+
+    Aabb bounds;
+    Aabb centroidBounds;
+    for (uint32_t i = first; i < first + count; ++i)
+    {
+        uint32_t k = indexes_[i];
+        bounds.grow(boxMin_[k], boxMax_[k]);
+        centroidBounds.grow(centroids_[k], centroids_[k]);
+    }
+
+    {
+        Node & node = nodes_[index];
+        node.min   = XMFLOAT3(bounds.min[0], bounds.min[1], bounds.min[2]);
+        node.max   = XMFLOAT3(bounds.max[0], bounds.max[1], bounds.max[2]);
+        node.first = first;
+        node.count = count;
+        node.right = 0;
+    }
+
+    if (count <= uint32_t(maxLeafSize_))
+        return index;
+
+    // Split along the axis with the largest spread of centroids
+
+    int axis = 0;
+    for (int i = 1; i < 3; ++i)
+    {
+        if (centroidBounds.max[i] - centroidBounds.min[i] > centroidBounds.max[axis] - centroidBounds.min[axis])
+            axis = i;
+    }
+
+    float const lo     = centroidBounds.min[axis];
+    float const extent = centroidBounds.max[axis] - lo;
+
+    uint32_t * pBegin = indexes_.data() + first;
+    uint32_t * pEnd   = pBegin + count;
+    uint32_t * pMid   = pBegin;
+
+    if (extent > 0.0f)
+    {
+        float const scale  = NUM_BINS / extent;
+        auto        binOf  = [&] (uint32_t k) {
+                                 int bin = int((Component(centroids_[k], axis) - lo) * scale);
+                                 return std::min(bin, NUM_BINS - 1);
+                             };
+
+        // Bin the objects
+
+        Aabb     binBounds[NUM_BINS];
+        uint32_t binCounts[NUM_BINS] = { 0 };
+        for (uint32_t * p = pBegin; p < pEnd; ++p)
+        {
+            int bin = binOf(*p);
+            binBounds[bin].grow(boxMin_[*p], boxMax_[*p]);
+            ++binCounts[bin];
+        }
+
+        // Evaluate the cost of splitting after each bin and choose the cheapest
+
+        float    rightCosts[NUM_BINS];
+        Aabb     rightBounds;
+        uint32_t rightCount = 0;
+        for (int i = NUM_BINS - 1; i > 0; --i)
+        {
+            rightBounds.grow(binBounds[i]);
+            rightCount   += binCounts[i];
+            rightCosts[i] = rightBounds.area() * rightCount;
+        }
+
+        float    bestCost  = FLT_MAX;
+        int      bestSplit = 0;
+        Aabb     leftBounds;
+        uint32_t leftCount = 0;
+        for (int i = 0; i < NUM_BINS - 1; ++i)
+        {
+            leftBounds.grow(binBounds[i]);
+            leftCount += binCounts[i];
+            float cost = leftBounds.area() * leftCount + rightCosts[i + 1];
+            if (cost < bestCost)
+            {
+                bestCost  = cost;
+                bestSplit = i;
+            }
+        }
+
+        pMid = std::partition(pBegin, pEnd, [&] (uint32_t k) { return binOf(k) <= bestSplit; });
+    }
+
+    // If the objects could not be separated, then split them in half.
+
+    if (pMid == pBegin || pMid == pEnd)
+    {
+        pMid = pBegin + count / 2;
+        std::nth_element(pBegin, pMid, pEnd, [&] (uint32_t a, uint32_t b) {
+                             return Component(centroids_[a], axis) < Component(centroids_[b], axis);
+                         });
+    }
+
+    uint32_t leftCount = uint32_t(pMid - pBegin);
+    uint32_t left      = Build(first, leftCount);
+    assert(left == index + 1);
+    (void)left;
+    uint32_t right = Build(first + leftCount, count - leftCount);
+    nodes_[index].right = right;
+
+    return index;
+}
+
+void BoundingVolumeHierarchy::Cull(CullingFrustum const & frustum,
+                                   std::vector<Range> &   visible,
+                                   uint8_t *              pLastPlanes,
+                                   CullStats *            pStats) const
+{
+    if (nodes_.empty())
+        return;
+
+    struct Entry
+    {
+        uint32_t node;
+        uint32_t planes;    // Planes that must still be tested
+    };
+
+    uint64_t nodesTested = 0;
+    uint64_t planeTests  = 0;
+
+    std::vector<Entry> stack;
+    stack.reserve(64);
+    stack.push_back({ 0, (1u << frustum.size()) - 1 });
+
+    while (!stack.empty())
+    {
+        Entry entry = stack.back();
+        stack.pop_back();
+
+        Node const & node = nodes_[entry.node];
+        float        cx   = (node.min.x + node.max.x) * 0.5f;
+        float        cy   = (node.min.y + node.max.y) * 0.5f;
+        float        cz   = (node.min.z + node.max.z) * 0.5f;
+        float        ex   = (node.max.x - node.min.x) * 0.5f;
+        float        ey   = (node.max.y - node.min.y) * 0.5f;
+        float        ez   = (node.max.z - node.min.z) * 0.5f;
+
+        // Returns the distance of the center past the plane and the projected radius of the node
+        auto test = [&] (int i, float * pRadius) {
+                        XMFLOAT4 const & p = frustum.plane(i);
+                        *pRadius = fabsf(p.x) * ex + fabsf(p.y) * ey + fabsf(p.z) * ez;
+                        ++planeTests;
+                        return p.x * cx + p.y * cy + p.z * cz + p.w;
+                    };
+
+        ++nodesTested;
+
+        // Test the plane that rejected this node last time first
+
+        int first = NO_PLANE;
+        if (pLastPlanes)
+        {
+            first = pLastPlanes[entry.node];
+            if (first < frustum.size() && (entry.planes & (1u << first)))
+            {
+                float radius;
+                float distance = test(first, &radius);
+                if (distance > radius)
+                    continue;
+                if (distance < -radius)
+                    entry.planes &= ~(1u << first);
+            }
+        }
+
+        bool outside = false;
+        for (int i = 0; i < frustum.size(); ++i)
+        {
+            if (i == first || !(entry.planes & (1u << i)))
+                continue;
+
+            float radius;
+            float distance = test(i, &radius);
+            if (distance > radius)
+            {
+                if (pLastPlanes)
+                    pLastPlanes[entry.node] = uint8_t(i);
+                outside = true;
+                break;
+            }
+            if (distance < -radius)
+                entry.planes &= ~(1u << i);
+        }
+
+        if (outside)
+            continue;
+
+        if (entry.planes == 0 || node.right == 0)
+        {
+            AppendRange(visible, node.first, node.count);
+        }
+        else
+        {
+            // The left child is pushed last so that it is visited first and the ranges are appended in order.
+            stack.push_back({ node.right, entry.planes });
+            stack.push_back({ entry.node + 1, entry.planes });
+        }
+    }
+
+    if (pStats)
+    {
+        pStats->boundsTested = nodesTested;
+        pStats->planeTests   = planeTests;
+    }
+}
+} // namespace Dxx
@@ -4,6 +4,42 @@
 
 using namespace DirectX;
 
+namespace
+{
+// Returns the radical inverse of i in the given base, which is element i of the Halton sequence in that base
+float RadicalInverse(unsigned i, unsigned base)
+{
+    float const inverseBase = 1.0f / float(base);
+    float       f           = inverseBase;
+    float       r           = 0.0f;
+    while (i > 0)
+    {
+        r += f * float(i % base);
+        i /= base;
+        f *= inverseBase;
+    }
+    return r;
+}
+
+// Returns the fractional part of a non-negative value
+float Fraction(float x)
+{
+    return x - floorf(x);
+}
+
+// Removes a jitter offset (in NDC) from a view-projection matrix. The jitter is applied by translating clip space by
+// the offset times w, so it is removed by subtracting the offset times the w column from the x and y columns.
+XMFLOAT4X4 Unjitter(XMFLOAT4X4 m, XMFLOAT2 const & jitter)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        m.m[i][0] -= jitter.x * m.m[i][3];
+        m.m[i][1] -= jitter.y * m.m[i][3];
+    }
+    return m;
+}
+} // anonymous namespace
+
 namespace Dxx
 {
 //! @param	angleOfView		The angle between the bottom and top of the view frustum (in degrees).
@@ -25,8 +61,18 @@ Camera::Camera(float            angleOfView,
     , frame_(position, orientation)
     , aspectRatio_(aspectRatio)
     , viewOffset_(0.0f, 0.0f)
+    , dirty_(ALL_DIRTY)
+    , stats_()
+    , jitterSequence_(JITTER_NONE)
+    , jitterScale_(0.0f, 0.0f)
+    , jitterLength_(1)
+    , jitter_(0.0f, 0.0f)
+    , previousJitter_(0.0f, 0.0f)
+    , frameIndex_(0)
+    , hasClipPlane_(false)
+    , clipPlane_(0.0f, 0.0f, 0.0f, 0.0f)
+    , batchDepth_(0)
 {
-    SyncInternalState();
 }
 
 //! @param	angleOfView		The angle between the bottom and top of the view frustum  (in degrees).
@@ -46,8 +92,18 @@ Camera::Camera(float         angleOfView,
     , frame_(frame)
     , aspectRatio_(aspectRatio)
     , viewOffset_(0.0f, 0.0f)
+    , dirty_(ALL_DIRTY)
+    , stats_()
+    , jitterSequence_(JITTER_NONE)
+    , jitterScale_(0.0f, 0.0f)
+    , jitterLength_(1)
+    , jitter_(0.0f, 0.0f)
+    , previousJitter_(0.0f, 0.0f)
+    , frameIndex_(0)
+    , hasClipPlane_(false)
+    , clipPlane_(0.0f, 0.0f, 0.0f, 0.0f)
+    , batchDepth_(0)
 {
-    SyncInternalState();
 }
 
 #if 0
@@ -71,36 +127,27 @@ void Camera::reshape()
 XMFLOAT3 Camera::position() const
 {
 #if defined(_DEBUG)
-    // Make sure that there is no scaling so we can simply extract the last row and avoid decomposition
+    // Make sure that there is no scaling, since the camera's position is the frame's translation
     XMFLOAT3 const scale = frame_.scale();
     assert(MyMath::IsCloseTo(scale.x, 1., MyMath::DEFAULT_FLOAT_NORMALIZED_TOLERANCE));
     assert(MyMath::IsCloseTo(scale.y, 1., MyMath::DEFAULT_FLOAT_NORMALIZED_TOLERANCE));
     assert(MyMath::IsCloseTo(scale.z, 1., MyMath::DEFAULT_FLOAT_NORMALIZED_TOLERANCE));
 #endif  // defined( _DEBUG )
 
-    XMFLOAT4X4 frame = frame_.transformation();
-    return { frame._41, frame._42, frame._43 };
+    return frame_.translation();
 }
 
 XMFLOAT4 Camera::orientation() const
 {
 #if defined(_DEBUG)
-    // Make sure that there is no scaling so we can simply extract the upper left 3x3 and avoid decomposition
+    // Make sure that there is no scaling, since the camera's orientation is the frame's orientation
     XMFLOAT3 const scale = frame_.scale();
     assert(MyMath::IsCloseTo(scale.x, 1., MyMath::DEFAULT_FLOAT_NORMALIZED_TOLERANCE));
     assert(MyMath::IsCloseTo(scale.y, 1., MyMath::DEFAULT_FLOAT_NORMALIZED_TOLERANCE));
     assert(MyMath::IsCloseTo(scale.z, 1., MyMath::DEFAULT_FLOAT_NORMALIZED_TOLERANCE));
 #endif  // defined( _DEBUG )
 
-    XMFLOAT4X4 frame = frame_.transformation();
-    XMFLOAT3X3 r(frame._11, frame._12, frame._13, frame._21, frame._22, frame._23, frame._31, frame._32, frame._33);
-    XMMATRIX   r_simd(XMLoadFloat3x3(&r));
-
-    XMVECTOR q_simd(XMQuaternionRotationMatrix(r_simd));
-
-    XMFLOAT4 q;
-    XMStoreFloat4(&q, q_simd);
-    return q;
+    return frame_.orientation();
 }
 
 void Camera::lookAt(XMFLOAT3 const & to, XMFLOAT3 const & from, XMFLOAT3 const & up)
@@ -113,7 +160,7 @@ void Camera::lookAt(XMFLOAT3 const & to, XMFLOAT3 const & from, XMFLOAT3 const &
     XMFLOAT4X4 lookat;
     XMStoreFloat4x4(&lookat, lookat_simd);
     frame_.setTransformation(lookat);
-    SyncInternalState();
+    InvalidateView();
 }
 
 //! @param	angle	Angle of rotation (in degrees)
@@ -129,7 +176,97 @@ void Camera::turn(float angle, XMFLOAT3 const & axis)
     XMStoreFloat4(&q, q_simd);
     turn(q);
 }
-void Camera::SyncViewMatrix()
+
+//! The projection matrix is modified so that its near plane is the given plane (E. Lengyel, "Oblique View Frustum
+//! Depth Projection and Clipping", Journal of Game Development, 2005), and the view frustum's front plane follows. This
+//! is used to clip the geometry behind a mirror or below the surface of water when rendering a reflection. The far
+//! plane is tilted as a side effect, which reduces the precision of the depth buffer somewhat.
+//!
+//! The plane is in world space, and points where dot(plane, (x, y, z, 1)) < 0 are clipped. The camera must be on that
+//! side of the plane; otherwise the plane is ignored.
+//!
+//! @param	plane	The clipping plane
+
+void Camera::setClipPlane(XMFLOAT4 const & plane)
+{
+    hasClipPlane_ = true;
+    clipPlane_    = plane;
+    InvalidateProjection();
+}
+
+//! The jitter offsets are in the range [-0.5, 0.5) pixels and are converted to normalized device coordinates using
+//! the size of the render target. The first offset is applied by the next call to nextFrame().
+//!
+//! @param	sequence	Jitter sequence
+//! @param	width		Width of the render target in pixels
+//! @param	height		Height of the render target in pixels
+//! @param	length		Number of offsets in the sequence before it repeats
+
+void Camera::setJitter(JitterSequence sequence, float width, float height, int length /*= 8*/)
+{
+    assert(width > 0.0f && height > 0.0f);
+    assert(length > 0);
+
+    jitterSequence_ = sequence;
+    jitterScale_    = XMFLOAT2(2.0f / width, -2.0f / height);    // Pixel y increases downward
+    jitterLength_   = length;
+
+    if (sequence == JITTER_NONE)
+    {
+        previousJitter_ = XMFLOAT2(0.0f, 0.0f);
+        if (jitter_.x != 0.0f || jitter_.y != 0.0f)
+        {
+            jitter_ = XMFLOAT2(0.0f, 0.0f);
+            InvalidateProjection();
+        }
+    }
+}
+
+//! This must be called once at the beginning of each frame, before the camera is changed for the frame. The current
+//! unjittered view-projection matrix and jitter offset become the previous ones, and the next offset in the jitter
+//! sequence is applied to the projection matrix.
+
+void Camera::nextFrame()
+{
+    previousViewProjectionMatrix_ = unjitteredViewProjectionMatrix();
+    previousJitter_ = jitter_;
+    ++frameIndex_;
+
+    if (jitterSequence_ == JITTER_NONE)
+        return;
+
+    unsigned const n = (frameIndex_ - 1) % unsigned(jitterLength_);
+    XMFLOAT2       offset;
+    if (jitterSequence_ == JITTER_HALTON)
+    {
+        // Element 0 of the Halton sequence is (0, 0) in every base, so it is skipped
+        offset = XMFLOAT2(RadicalInverse(n + 1, 2), RadicalInverse(n + 1, 3));
+    }
+    else
+    {
+        float const g = 1.32471795724474602596f;   // The plastic number
+        offset = XMFLOAT2(Fraction(0.5f + float(n) / g), Fraction(0.5f + float(n) / (g * g)));
+    }
+
+    jitter_ = XMFLOAT2((offset.x - 0.5f) * jitterScale_.x, (offset.y - 0.5f) * jitterScale_.y);
+    InvalidateProjection();
+}
+
+XMFLOAT4X4 Camera::unjitteredViewProjectionMatrix() const
+{
+    return Unjitter(viewProjectionMatrix(), jitter_);
+}
+
+//! Before the first call to nextFrame(), this is the current unjittered view-projection matrix.
+
+XMFLOAT4X4 Camera::previousViewProjectionMatrix() const
+{
+    if (frameIndex_ == 0)
+        return unjitteredViewProjectionMatrix();
+    return previousViewProjectionMatrix_;
+}
+
+void Camera::SyncViewMatrix() const
 {
 // Yuck this is slow...there is a faster way
 //
@@ -144,7 +281,7 @@ void Camera::SyncViewMatrix()
     // Note the transformation is inverted (because, in reality, the camera remains at the origin and world space
     // is transformed). Also the inversion reverses the order of rotation and translation.
 
-    // Get the rotation and invert it (by transposing).
+    // Get the rotation and invert it (by conjugating).
 
 #if defined(_DEBUG)
 
@@ -158,22 +295,25 @@ void Camera::SyncViewMatrix()
 
 #endif  // defined( _DEBUG )
 
-    XMFLOAT4X4 frame = frame_.transformation();
-    XMFLOAT3X3 r(frame._11, frame._12, frame._13, frame._21, frame._22, frame._23, frame._31, frame._32, frame._33);
-    XMFLOAT3   t(frame._41, frame._42, frame._43);
-    XMMATRIX   r_simd(XMLoadFloat3x3(&r));
-    XMVECTOR   t_simd(XMLoadFloat3(&t));
+    XMFLOAT3 const t = frame_.translation();
+    XMFLOAT4 const q = frame_.orientation();
+    XMVECTOR       t_simd(XMLoadFloat3(&t));
+    XMVECTOR       q_simd(XMLoadFloat4(&q));
 
-    XMMATRIX ir_simd = XMMatrixTranspose(r_simd);
+    // The inverse of the rotation is the rotation by the conjugate of the quaternion
+    XMMATRIX ir_simd = XMMatrixRotationQuaternion(XMQuaternionConjugate(q_simd));
     XMMATRIX it_simd = XMMatrixTranslationFromVector(-t_simd);
 
     // Compute the view matrix
     XMMATRIX view_simd = it_simd * ir_simd;
 
     XMStoreFloat4x4(&viewMatrix_, view_simd);
+
+    dirty_ &= ~VIEW_MATRIX_DIRTY;
+    ++stats_.viewMatrixUpdates;
 }
 
-void Camera::SyncProjectionMatrix()
+void Camera::SyncProjectionMatrix() const
 {
     float const h = tanf(angleOfView_ * 0.5f) * nearDistance_;
     float const w = h * aspectRatio_;
@@ -186,22 +326,63 @@ void Camera::SyncProjectionMatrix()
                                                               viewOffset_.y + h,
                                                               nearDistance_, farDistance_);
     XMStoreFloat4x4(&projectionMatrix_, projection_simd);
-}
 
-//!
-//! @note	This function should be called whenever any value is modified directly.
+    // Apply the jitter by translating clip space by the offset times w
+    for (int i = 0; i < 4; ++i)
+    {
+        projectionMatrix_.m[i][0] += jitter_.x * projectionMatrix_.m[i][3];
+        projectionMatrix_.m[i][1] += jitter_.y * projectionMatrix_.m[i][3];
+    }
 
-void Camera::SyncInternalState()
-{
-    // Sync the view matrix
+    if (hasClipPlane_)
+        ApplyClipPlane();
 
-    SyncViewMatrix();
+    dirty_ &= ~PROJECTION_MATRIX_DIRTY;
+    ++stats_.projectionMatrixUpdates;
+}
 
-    // Sync the projection matrix
+void Camera::ApplyClipPlane() const
+{
+    // Transform the plane into view space. The frame's transformation is the inverse of the view matrix, so its
+    // transpose transforms planes from world space to view space.
+
+    XMFLOAT4X4 frame      = frame_.transformation();
+    XMMATRIX   frame_simd = XMLoadFloat4x4(&frame);
+    XMVECTOR   c_simd     = XMPlaneTransform(XMLoadFloat4(&clipPlane_), XMMatrixTranspose(frame_simd));
+
+    // The camera must be on the clipped side of the plane
+    if (XMVectorGetW(c_simd) >= 0.0f)
+        return;
+
+    // Find the corner of the view volume opposite the plane (in view space), and scale the plane so that the corner
+    // is on the far plane after the near plane is replaced. Then replace the z column with the scaled plane.
+
+    XMMATRIX projection_simd = XMLoadFloat4x4(&projectionMatrix_);
+    XMVECTOR corner_simd     = XMVectorSet(XMVectorGetX(c_simd) >= 0.0f ? 1.0f : -1.0f,
+                                           XMVectorGetY(c_simd) >= 0.0f ? 1.0f : -1.0f,
+                                           1.0f,
+                                           1.0f);
+    XMVECTOR q_simd = XMVector4Transform(corner_simd, XMMatrixInverse(nullptr, projection_simd));
+
+    XMFLOAT4X4 const & p      = projectionMatrix_;
+    XMVECTOR           w_simd = XMVectorSet(p._14, p._24, p._34, p._44);
+    float              scale  = XMVectorGetX(XMVector4Dot(w_simd, q_simd)) / XMVectorGetX(XMVector4Dot(c_simd, q_simd));
+
+    XMFLOAT4 c;
+    XMStoreFloat4(&c, c_simd);
+    projectionMatrix_._13 = c.x * scale;
+    projectionMatrix_._23 = c.y * scale;
+    projectionMatrix_._33 = c.z * scale;
+    projectionMatrix_._43 = c.w * scale;
+}
 
-    SyncProjectionMatrix();
+void Camera::SyncViewProjectionMatrix() const
+{
+    if (dirty_ & VIEW_MATRIX_DIRTY)
+        SyncViewMatrix();
 
-    // Compute the view-projection matrix
+    if (dirty_ & PROJECTION_MATRIX_DIRTY)
+        SyncProjectionMatrix();
 
     XMMATRIX view_simd(XMLoadFloat4x4(&viewMatrix_));
     XMMATRIX projection_simd(XMLoadFloat4x4(&projectionMatrix_));
@@ -209,12 +390,26 @@ void Camera::SyncInternalState()
 
     XMStoreFloat4x4(&viewProjectionMatrix_, viewProjection_simd);
 
-    // Compute the view frustum
+    dirty_ &= ~VIEW_PROJECTION_MATRIX_DIRTY;
+    ++stats_.viewProjectionMatrixUpdates;
+}
 
-    ComputeViewFrustum(viewProjectionMatrix_);
+//! Only the values that are out of date are recomputed. The derived values are normally brought up to date when they
+//! are requested, so this only needs to be called in order to make all the values consistent at once, for example
+//! before the camera is read concurrently by several threads.
+//!
+//! @note	If a derived class modifies a value directly, it must call InvalidateView() or InvalidateProjection().
+
+void Camera::SyncInternalState()
+{
+    if (dirty_ & VIEW_PROJECTION_MATRIX_DIRTY)
+        SyncViewProjectionMatrix();
+
+    if (dirty_ & VIEW_FRUSTUM_DIRTY)
+        ComputeViewFrustum(viewProjectionMatrix_);
 }
 
-void Camera::ComputeViewFrustum(XMFLOAT4X4 const & m)
+void Camera::ComputeViewFrustum(XMFLOAT4X4 const & m) const
 {
     viewFrustum_.sides_[Frustum::LEFT_SIDE]   = Plane(-m._14 - m._11, -m._24 - m._21, -m._34 - m._31, -m._44 - m._41);
     viewFrustum_.sides_[Frustum::RIGHT_SIDE]  = Plane(-m._14 + m._11, -m._24 + m._21, -m._34 + m._31, -m._44 + m._41);
@@ -222,5 +417,8 @@ void Camera::ComputeViewFrustum(XMFLOAT4X4 const & m)
     viewFrustum_.sides_[Frustum::BOTTOM_SIDE] = Plane(-m._14 - m._12, -m._24 - m._22, -m._34 - m._32, -m._44 - m._42);
     viewFrustum_.sides_[Frustum::FRONT_SIDE]  = Plane(-m._13,         -m._23,         -m._33,         -m._43);
     viewFrustum_.sides_[Frustum::BACK_SIDE]   = Plane(-m._14 + m._13, -m._24 + m._23, -m._34 + m._33, -m._44 + m._43);
+
+    dirty_ &= ~VIEW_FRUSTUM_DIRTY;
+    ++stats_.viewFrustumUpdates;
 }
 } // namespace Dxx
@@ -0,0 +1,337 @@
+#include "CameraBatch.h"
+
+#include "Camera.h"
+#include "MyMath/MyMath.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace DirectX;
+
+namespace
+{
+int constexpr NUM_SIDES = 6;    // Number of planes in a view frustum
+
+// Loads 4 consecutive values, padding past the end with the given value
+XMVECTOR Load4(std::vector<float> const & v, size_t i, float pad)
+{
+    if (i + 4 <= v.size())
+        return XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(&v[i]));
+
+    XMFLOAT4 padded(pad, pad, pad, pad);
+    float *  p = &padded.x;
+    for (size_t j = i; j < v.size(); ++j)
+    {
+        p[j - i] = v[j];
+    }
+    return XMLoadFloat4(&padded);
+}
+
+// Transposes a 4x4 block of values whose lanes are cameras and stores the rows of the first n cameras.
+void StoreRow(XMVECTOR const e[4], size_t n, XMFLOAT4 * pOut, size_t stride)
+{
+    XMMATRIX t = XMMatrixTranspose(XMMATRIX(e[0], e[1], e[2], e[3]));
+    for (size_t k = 0; k < n; ++k)
+    {
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4 *>(reinterpret_cast<char *>(pOut) + k * stride), t.r[k]);
+    }
+}
+
+// Stores the matrixes of the first n cameras. The lanes of m[i][j] are the _ij values of 4 cameras.
+void StoreMatrixes(XMVECTOR const m[4][4], size_t n, XMFLOAT4X4 * pOut)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        StoreRow(m[i], n, reinterpret_cast<XMFLOAT4 *>(pOut->m[i]), sizeof(XMFLOAT4X4));
+    }
+}
+} // anonymous namespace
+
+namespace Dxx
+{
+//! @param	n	Number of cameras to reserve space for
+
+void CameraBatch::reserve(size_t n)
+{
+    for (auto * v : { &positionX_, &positionY_, &positionZ_,
+                      &orientationX_, &orientationY_, &orientationZ_, &orientationW_,
+                      &angleOfView_, &nearDistance_, &farDistance_, &aspectRatio_, &viewOffsetX_, &viewOffsetY_ })
+    {
+        v->reserve(n);
+    }
+    viewMatrixes_.reserve(n);
+    projectionMatrixes_.reserve(n);
+    viewProjectionMatrixes_.reserve(n);
+    frustumPlanes_.reserve(n * NUM_SIDES);
+}
+
+//! @param	camera	Camera whose values are copied into the batch
+//!
+//! @return		The index of the camera in the batch
+//!
+//! @note	The derived values of the new camera are not valid until update() is called.
+
+size_t CameraBatch::add(Camera const & camera)
+{
+    size_t i = size();
+    for (auto * v : { &positionX_, &positionY_, &positionZ_,
+                      &orientationX_, &orientationY_, &orientationZ_, &orientationW_,
+                      &angleOfView_, &nearDistance_, &farDistance_, &aspectRatio_, &viewOffsetX_, &viewOffsetY_ })
+    {
+        v->push_back(0.0f);
+    }
+    viewMatrixes_.emplace_back();
+    projectionMatrixes_.emplace_back();
+    viewProjectionMatrixes_.emplace_back();
+    frustumPlanes_.resize(frustumPlanes_.size() + NUM_SIDES);
+
+    set(i, camera);
+    return i;
+}
+
+//! @param	i		Index of the camera in the batch
+//! @param	camera	Camera whose values are copied into the batch
+
+void CameraBatch::set(size_t i, Camera const & camera)
+{
+    setFrame(i, camera.position(), camera.orientation());
+    angleOfView_[i]  = camera.angleOfView_;
+    nearDistance_[i] = camera.nearDistance_;
+    farDistance_[i]  = camera.farDistance_;
+    aspectRatio_[i]  = camera.aspectRatio_;
+    setViewOffset(i, camera.viewOffset_.x, camera.viewOffset_.y);
+}
+
+//! @param	i				Index of the camera in the batch
+//! @param	position		New position
+//! @param	orientation		New orientation
+
+void CameraBatch::setFrame(size_t i, XMFLOAT3 const & position, XMFLOAT4 const & orientation)
+{
+    assert(i < size());
+
+    positionX_[i]    = position.x;
+    positionY_[i]    = position.y;
+    positionZ_[i]    = position.z;
+    orientationX_[i] = orientation.x;
+    orientationY_[i] = orientation.y;
+    orientationZ_[i] = orientation.z;
+    orientationW_[i] = orientation.w;
+}
+
+//! @param	i				Index of the camera in the batch
+//! @param	angleOfView		The angle between the bottom and top of the view frustum (in degrees).
+//! @param	nearDistance	The distance to the near clipping plane.
+//! @param	farDistance		The distance to the far clipping plane.
+//! @param	aspectRatio		View window w / h
+
+void CameraBatch::setProjection(size_t i, float angleOfView, float nearDistance, float farDistance, float aspectRatio)
+{
+    assert(i < size());
+    assert(aspectRatio > 0.0f);
+
+    angleOfView_[i]  = MyMath::ToRadians(angleOfView);
+    nearDistance_[i] = nearDistance;
+    farDistance_[i]  = farDistance;
+    aspectRatio_[i]  = aspectRatio;
+}
+
+//! @param	i	Index of the camera in the batch
+//! @param	x	X-offset to the center of the near plane in view space.
+//! @param	y	Y-offset to the center of the near plane in view space.
+
+void CameraBatch::setViewOffset(size_t i, float x, float y)
+{
+    assert(i < size());
+
+    viewOffsetX_[i] = x;
+    viewOffsetY_[i] = y;
+}
+
+void CameraBatch::clear()
+{
+    for (auto * v : { &positionX_, &positionY_, &positionZ_,
+                      &orientationX_, &orientationY_, &orientationZ_, &orientationW_,
+                      &angleOfView_, &nearDistance_, &farDistance_, &aspectRatio_, &viewOffsetX_, &viewOffsetY_ })
+    {
+        v->clear();
+    }
+    viewMatrixes_.clear();
+    projectionMatrixes_.clear();
+    viewProjectionMatrixes_.clear();
+    frustumPlanes_.clear();
+}
+
+void CameraBatch::update()
+{
+    for (size_t i = 0; i < size(); i += 4)
+    {
+        update4(i);
+    }
+}
+
+//! @param	i	Index of the camera in the batch
+
+Frustum CameraBatch::viewFrustum(size_t i) const
+{
+    assert(i < size());
+
+    Frustum frustum;
+    for (int side = 0; side < NUM_SIDES; ++side)
+    {
+        XMFLOAT4 const & p = frustumPlanes_[i * NUM_SIDES + side];
+        frustum.sides_[side] = Plane(p.x, p.y, p.z, p.w);
+    }
+    return frustum;
+}
+
+//! The camera's frame of reference and projection parameters are replaced by the values in the batch, and its derived
+//! values are replaced by the values computed by the last call to update(). If the camera's projection is jittered or
+//! has an oblique clip plane, the camera recomputes its projection matrix and the values derived from it instead.
+//!
+//! @param	i		Index of the camera in the batch
+//! @param	camera	Camera to receive the values
+
+void CameraBatch::readBack(size_t i, Camera & camera) const
+{
+    assert(i < size());
+
+    camera.frame_ = Frame(XMFLOAT3(positionX_[i], positionY_[i], positionZ_[i]),
+                          XMFLOAT4(orientationX_[i], orientationY_[i], orientationZ_[i], orientationW_[i]));
+    camera.angleOfView_          = angleOfView_[i];
+    camera.nearDistance_         = nearDistance_[i];
+    camera.farDistance_          = farDistance_[i];
+    camera.aspectRatio_          = aspectRatio_[i];
+    camera.viewOffset_           = XMFLOAT2(viewOffsetX_[i], viewOffsetY_[i]);
+    camera.viewMatrix_           = viewMatrixes_[i];
+    camera.projectionMatrix_     = projectionMatrixes_[i];
+    camera.viewProjectionMatrix_ = viewProjectionMatrixes_[i];
+    camera.viewFrustum_          = viewFrustum(i);
+    camera.dirty_ = 0;
+
+    // The batch's projection matrixes include neither the camera's jitter nor its clip plane, so the camera must
+    // recompute its own
+    if (camera.jitter_.x != 0.0f || camera.jitter_.y != 0.0f || camera.hasClipPlane_)
+        camera.InvalidateProjection();
+}
+
+void CameraBatch::update4(size_t i)
+{
+    size_t const n = std::min<size_t>(size() - i, 4);
+
+    XMVECTOR const one  = XMVectorSplatOne();
+    XMVECTOR const zero = XMVectorZero();
+    XMVECTOR const two  = XMVectorReplicate(2.0f);
+
+    // Rotation matrixes (the same as XMMatrixRotationQuaternion)
+
+    XMVECTOR qx = Load4(orientationX_, i, 0.0f);
+    XMVECTOR qy = Load4(orientationY_, i, 0.0f);
+    XMVECTOR qz = Load4(orientationZ_, i, 0.0f);
+    XMVECTOR qw = Load4(orientationW_, i, 1.0f);
+
+    XMVECTOR xx = qx * qx;
+    XMVECTOR yy = qy * qy;
+    XMVECTOR zz = qz * qz;
+    XMVECTOR xy = qx * qy;
+    XMVECTOR xz = qx * qz;
+    XMVECTOR yz = qy * qz;
+    XMVECTOR xw = qx * qw;
+    XMVECTOR yw = qy * qw;
+    XMVECTOR zw = qz * qw;
+
+    XMVECTOR r11 = one - two * (yy + zz);
+    XMVECTOR r12 = two * (xy + zw);
+    XMVECTOR r13 = two * (xz - yw);
+    XMVECTOR r21 = two * (xy - zw);
+    XMVECTOR r22 = one - two * (xx + zz);
+    XMVECTOR r23 = two * (yz + xw);
+    XMVECTOR r31 = two * (xz + yw);
+    XMVECTOR r32 = two * (yz - xw);
+    XMVECTOR r33 = one - two * (xx + yy);
+
+    // View matrixes (the same as Camera::SyncViewMatrix): V = T(-t) * transpose(R)
+
+    XMVECTOR tx = Load4(positionX_, i, 0.0f);
+    XMVECTOR ty = Load4(positionY_, i, 0.0f);
+    XMVECTOR tz = Load4(positionZ_, i, 0.0f);
+
+    XMVECTOR v[4][4] =
+    {
+        { r11, r21, r31, zero },
+        { r12, r22, r32, zero },
+        { r13, r23, r33, zero },
+        {
+            -(tx * r11 + ty * r12 + tz * r13),
+            -(tx * r21 + ty * r22 + tz * r23),
+            -(tx * r31 + ty * r32 + tz * r33),
+            one
+        }
+    };
+
+    // Projection matrixes (the same as Camera::SyncProjectionMatrix)
+
+    XMVECTOR angleOfView  = Load4(angleOfView_, i, XM_PIDIV2);
+    XMVECTOR nearDistance = Load4(nearDistance_, i, 1.0f);
+    XMVECTOR farDistance  = Load4(farDistance_, i, 2.0f);
+    XMVECTOR aspectRatio  = Load4(aspectRatio_, i, 1.0f);
+    XMVECTOR offsetX      = Load4(viewOffsetX_, i, 0.0f);
+    XMVECTOR offsetY      = Load4(viewOffsetY_, i, 0.0f);
+
+    XMVECTOR h     = XMVectorTan(angleOfView * XMVectorReplicate(0.5f)) * nearDistance;
+    XMVECTOR w     = h * aspectRatio;
+    XMVECTOR invW  = XMVectorReciprocal(w);
+    XMVECTOR invH  = XMVectorReciprocal(h);
+    XMVECTOR range = farDistance / (farDistance - nearDistance);
+
+    XMVECTOR p11 = nearDistance * invW;
+    XMVECTOR p22 = nearDistance * invH;
+    XMVECTOR p31 = -offsetX * invW;
+    XMVECTOR p32 = -offsetY * invH;
+    XMVECTOR p33 = range;
+    XMVECTOR p43 = -range * nearDistance;
+
+    XMVECTOR p[4][4] =
+    {
+        { p11,  zero, zero, zero },
+        { zero, p22,  zero, zero },
+        { p31,  p32,  p33,  one  },
+        { zero, zero, p43,  zero }
+    };
+
+    // View-projection matrixes. Most of the elements of the projection matrix are 0, so the product is simplified.
+
+    XMVECTOR vp[4][4];
+    for (int r = 0; r < 4; ++r)
+    {
+        vp[r][0] = v[r][0] * p11 + v[r][2] * p31;
+        vp[r][1] = v[r][1] * p22 + v[r][2] * p32;
+        vp[r][2] = v[r][2] * p33 + v[r][3] * p43;
+        vp[r][3] = v[r][2];
+    }
+
+    // Frustum planes (the same as Camera::ComputeViewFrustum). The lanes of planes[side][r] are component r of
+    // the plane of 4 cameras.
+
+    XMVECTOR planes[NUM_SIDES][4];
+    for (int r = 0; r < 4; ++r)
+    {
+        planes[Frustum::LEFT_SIDE][r]   = -vp[r][3] - vp[r][0];
+        planes[Frustum::RIGHT_SIDE][r]  = -vp[r][3] + vp[r][0];
+        planes[Frustum::TOP_SIDE][r]    = -vp[r][3] + vp[r][1];
+        planes[Frustum::BOTTOM_SIDE][r] = -vp[r][3] - vp[r][1];
+        planes[Frustum::FRONT_SIDE][r]  = -vp[r][2];
+        planes[Frustum::BACK_SIDE][r]   = -vp[r][3] + vp[r][2];
+    }
+
+    // Store the results
+
+    StoreMatrixes(v, n, &viewMatrixes_[i]);
+    StoreMatrixes(p, n, &projectionMatrixes_[i]);
+    StoreMatrixes(vp, n, &viewProjectionMatrixes_[i]);
+    for (int side = 0; side < NUM_SIDES; ++side)
+    {
+        StoreRow(planes[side], n, &frustumPlanes_[i * NUM_SIDES + side], NUM_SIDES * sizeof(XMFLOAT4));
+    }
+}
+} // namespace Dxx
@@ -0,0 +1,70 @@
+#include "CameraChannel.h"
+
+#include "Camera.h"
+
+using namespace DirectX;
+
+namespace Dxx
+{
+//! All of the buffers start with a snapshot of the camera, so acquire() returns a valid snapshot even before the
+//! first call to publish().
+//!
+//! @param	camera	The camera
+
+CameraChannel::CameraChannel(Camera const & camera)
+    : ready_(1)
+    , writeBuffer_(0)
+    , sequence_(0)
+    , readBuffer_(2)
+{
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        Capture(camera, i);
+    }
+}
+
+//! The camera's derived values are brought up to date (if necessary) and copied, so the camera must not be modified
+//! by another thread during the call.
+//!
+//! @param	camera	The camera
+
+void CameraChannel::publish(Camera const & camera)
+{
+    ++sequence_;
+    Capture(camera, writeBuffer_);
+
+    // The release half of the exchange makes the snapshot visible to the reader before the buffer is. The acquire half
+    // makes sure that the reader is done with the buffer that is being taken back.
+    writeBuffer_ = ready_.exchange(writeBuffer_ | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
+
+//! If no snapshot has been published since the previous call, the same snapshot is returned again.
+//!
+//! @return		The most recently published snapshot. It remains valid until the next call.
+
+CameraSnapshot const & CameraChannel::acquire()
+{
+    if (ready_.load(std::memory_order_relaxed) & FRESH)
+        readBuffer_ = ready_.exchange(readBuffer_, std::memory_order_acq_rel) & ~FRESH;
+    return buffers_[readBuffer_];
+}
+
+void CameraChannel::Capture(Camera const & camera, uint32_t buffer)
+{
+    CameraSnapshot & s = buffers_[buffer];
+    s.viewMatrix                   = camera.viewMatrix();
+    s.projectionMatrix             = camera.projectionMatrix();
+    s.viewProjectionMatrix         = camera.viewProjectionMatrix();
+    s.previousViewProjectionMatrix = camera.previousViewProjectionMatrix();
+    s.viewFrustum                  = camera.viewFrustum();
+    s.frame                        = camera.frame();
+    s.nearDistance                 = camera.nearDistance();
+    s.farDistance                  = camera.farDistance();
+    s.angleOfView                  = camera.angleOfView();
+    s.aspectRatio                  = camera.aspectRatio();
+    s.viewOffset                   = camera.viewOffset();
+    s.jitter                       = camera.jitter();
+    s.jitterDelta                  = camera.jitterDelta();
+    s.sequence                     = sequence_;
+}
+} // namespace Dxx
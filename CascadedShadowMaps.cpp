@@ -0,0 +1,154 @@
+#include "CascadedShadowMaps.h"
+
+#include "Camera.h"
+#include "Light.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace Dxx
+{
+//! The distance of split @e i is
+//!
+//!		lambda * n * (f / n) ^ (i / count) + (1 - lambda) * (n + (f - n) * i / count)
+//!
+//! so pSplits[0] is the near distance and pSplits[count] is the far distance.
+//!
+//! @param	nearDistance	Distance to the camera's near clipping plane
+//! @param	farDistance		Distance to the camera's far clipping plane (or the maximum shadow distance)
+//! @param	count			Number of cascades
+//! @param	lambda			Blend between uniform (0) and logarithmic (1) splits
+//! @param	pSplits			Where to store the distances. The array must have room for @a count + 1 values.
+
+void ComputeCascadeSplits(float nearDistance, float farDistance, int count, float lambda, float * pSplits)
+{
+    assert(nearDistance > 0.0f && farDistance > nearDistance);
+    assert(count > 0);
+
+    float const ratio = farDistance / nearDistance;
+    for (int i = 0; i <= count; ++i)
+    {
+        float t           = float(i) / float(count);
+        float logarithmic = nearDistance * powf(ratio, t);
+        float uniform     = nearDistance + (farDistance - nearDistance) * t;
+        pSplits[i] = lambda * logarithmic + (1.0f - lambda) * uniform;
+    }
+    pSplits[0]     = nearDistance;
+    pSplits[count] = farDistance;
+}
+
+//! The corners of each cascade are computed from the camera's frame of reference, angle of view, aspect ratio, and
+//! view offset, so no matrixes are inverted. Each cascade's light-space projection is an orthographic box around the
+//! bounding sphere of the corners of the cascade. The size of the box does not change when the camera rotates, and its
+//! origin is snapped to multiples of the size of a texel, so that the shadows do not shimmer when the camera moves.
+//! The box extends @a casterDistance toward the light beyond the cascade, so that objects outside of the cascade can
+//! cast shadows into it.
+//!
+//! @param	camera			The camera (which must not be scaled)
+//! @param	light			The light
+//! @param	count			Number of cascades
+//! @param	lambda			Blend between uniform (0) and logarithmic (1) splits
+//! @param	resolution		Width and height of each shadow map in texels
+//! @param	casterDistance	Distance toward the light that shadow casters can be outside of a cascade
+//! @param	pCascades		Where to store the cascades. The array must have room for @a count cascades.
+
+void ComputeShadowCascades(Camera const &           camera,
+                           DirectionalLight const & light,
+                           int                      count,
+                           float                    lambda,
+                           int                      resolution,
+                           float                    casterDistance,
+                           ShadowCascade *          pCascades)
+{
+    assert(count > 0 && count <= 16);
+    assert(resolution > 1);
+
+    float splits[17];
+    ComputeCascadeSplits(camera.nearDistance(), camera.farDistance(), count, lambda, splits);
+
+    // The light's view matrix only rotates, so the texel grid stays fixed in world space
+
+    XMFLOAT3 const direction      = light.direction();
+    XMVECTOR const direction_simd = XMVector3Normalize(XMLoadFloat3(&direction));
+    XMVECTOR const up_simd        = (fabsf(XMVectorGetY(direction_simd)) > 0.99f)
+                                    ? XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f)
+                                    : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+    XMMATRIX const lightView_simd = XMMatrixLookToLH(XMVectorZero(), direction_simd, up_simd);
+
+    // A point at view-space depth d on the edge of the view window is at (offset * d / n +/- (w, h) * d / n, d)
+
+    float const    tanHalfAngle = tanf(camera.angleOfView() * 0.5f);
+    float const    aspectRatio  = camera.aspectRatio();
+    XMFLOAT2 const offset       = camera.viewOffset();
+    float const    nearDistance = camera.nearDistance();
+    XMFLOAT4X4     frame        = camera.frame().transformation();
+    XMMATRIX const toLight_simd = XMLoadFloat4x4(&frame) * lightView_simd;
+
+    for (int i = 0; i < count; ++i)
+    {
+        ShadowCascade & cascade = pCascades[i];
+        cascade.nearDistance = splits[i];
+        cascade.farDistance  = splits[i + 1];
+
+        // The corners of the cascade in the camera's space
+
+        XMVECTOR corners[8];
+        XMVECTOR center = XMVectorZero();
+        for (int j = 0; j < 8; ++j)
+        {
+            float d = (j & 4) ? cascade.farDistance : cascade.nearDistance;
+            float h = tanHalfAngle * d;
+            float w = h * aspectRatio;
+            float x = offset.x * d / nearDistance + ((j & 1) ? w : -w);
+            float y = offset.y * d / nearDistance + ((j & 2) ? h : -h);
+            corners[j] = XMVectorSet(x, y, d, 1.0f);
+            center     = center + corners[j];
+        }
+        center = center * XMVectorReplicate(1.0f / 8.0f);
+
+        // The width and height of the box are the diameter of a sphere around the corners, which does not change when
+        // the camera rotates, so the size of a texel does not change either. The radius is rounded up so that
+        // rounding errors do not change it from frame to frame. One texel is added so that snapping the box's origin
+        // to the texel grid does not uncover the sphere.
+
+        float radius = 0.0f;
+        for (int j = 0; j < 8; ++j)
+        {
+            radius = std::max(radius, XMVectorGetX(XMVector3Length(corners[j] - center)));
+        }
+        radius = ceilf(radius * 16.0f) / 16.0f;
+
+        float const extent = 2.0f * radius * float(resolution) / float(resolution - 1);
+        float const texel  = extent / float(resolution);
+
+        // Only the origin of the box is snapped to the texel grid, so that its size stays exactly resolution texels.
+        // The depth range is fitted to the corners, since it does not affect the texel grid.
+
+        XMFLOAT3 c;
+        XMStoreFloat3(&c, XMVector3TransformCoord(center, toLight_simd));
+
+        XMFLOAT3 lo;
+        XMFLOAT3 hi;
+        lo.x = floorf((c.x - radius) / texel) * texel;
+        lo.y = floorf((c.y - radius) / texel) * texel;
+        hi.x = lo.x + extent;
+        hi.y = lo.y + extent;
+        lo.z = FLT_MAX;
+        hi.z = -FLT_MAX;
+        for (int j = 0; j < 8; ++j)
+        {
+            float z = XMVectorGetZ(XMVector3TransformCoord(corners[j], toLight_simd));
+            lo.z = std::min(lo.z, z);
+            hi.z = std::max(hi.z, z);
+        }
+
+        XMMATRIX projection_simd = XMMatrixOrthographicOffCenterLH(lo.x, hi.x, lo.y, hi.y, lo.z - casterDistance, hi.z);
+        XMStoreFloat4x4(&cascade.viewProjection, lightView_simd * projection_simd);
+        cascade.frustum = CullingFrustum(cascade.viewProjection);
+    }
+}
+} // namespace Dxx
@@ -0,0 +1,436 @@
+#include "Culling.h"
+
+#include "ParallelFor.h"
+#include "SimdLanes.h"
+
+#include <algorithm>
+#include <cassert>
+#include <atomic>
+#include <cmath>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace DirectX;
+using Dxx::LaneBits;
+using Dxx::Load4;
+
+namespace
+{
+size_t constexpr GRAIN = 4096;  // Number of objects culled by a thread at a time (must be a multiple of 32)
+uint8_t constexpr NO_PLANE = 0xff; // Indicates that an object was not rejected by any plane
+
+// The planes of a culling volume, with each component replicated across all 4 lanes
+struct SplatPlanes
+{
+    explicit SplatPlanes(Dxx::CullingFrustum const & frustum)
+        : count(frustum.size())
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            XMFLOAT4 const & p = frustum.plane(i);
+            a[i]    = XMVectorReplicate(p.x);
+            b[i]    = XMVectorReplicate(p.y);
+            c[i]    = XMVectorReplicate(p.z);
+            d[i]    = XMVectorReplicate(p.w);
+            absA[i] = XMVectorReplicate(fabsf(p.x));
+            absB[i] = XMVectorReplicate(fabsf(p.y));
+            absC[i] = XMVectorReplicate(fabsf(p.z));
+        }
+    }
+
+    XMVECTOR a[Dxx::CullingFrustum::MAX_PLANES];
+    XMVECTOR b[Dxx::CullingFrustum::MAX_PLANES];
+    XMVECTOR c[Dxx::CullingFrustum::MAX_PLANES];
+    XMVECTOR d[Dxx::CullingFrustum::MAX_PLANES];
+    XMVECTOR absA[Dxx::CullingFrustum::MAX_PLANES];
+    XMVECTOR absB[Dxx::CullingFrustum::MAX_PLANES];
+    XMVECTOR absC[Dxx::CullingFrustum::MAX_PLANES];
+    int count;
+};
+
+// Returns the index of the lowest set bit
+int LowestBit(uint32_t x)
+{
+    assert(x != 0);
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward(&i, x);
+    return (int)i;
+#else
+    return __builtin_ctz(x);
+#endif
+}
+
+// Classifies 4 spheres. Stops testing as soon as all 4 are known to be outside.
+void ClassifySpheres4(SplatPlanes const & planes,
+                      XMVECTOR x, XMVECTOR y, XMVECTOR z, XMVECTOR r,
+                      XMVECTOR * pOutside, XMVECTOR * pInside)
+{
+    XMVECTOR const allTrue = XMVectorTrueInt();
+    XMVECTOR const negR    = XMVectorNegate(r);
+    XMVECTOR       outside = XMVectorFalseInt();
+    XMVECTOR       inside  = allTrue;
+
+    for (int i = 0; i < planes.count; ++i)
+    {
+        XMVECTOR distance = XMVectorMultiplyAdd(planes.a[i], x,
+                                                XMVectorMultiplyAdd(planes.b[i], y,
+                                                                    XMVectorMultiplyAdd(planes.c[i], z, planes.d[i])));
+        outside = XMVectorOrInt(outside, XMVectorGreater(distance, r));
+        inside  = XMVectorAndInt(inside, XMVectorLess(distance, negR));
+        if (XMVector4EqualInt(outside, allTrue))
+            break;
+    }
+
+    *pOutside = outside;
+    *pInside  = inside;
+}
+
+// Classifies 4 boxes given as centers and half-extents. Stops testing as soon as all 4 are known to be outside.
+void ClassifyBoxes4(SplatPlanes const & planes,
+                    XMVECTOR cx, XMVECTOR cy, XMVECTOR cz,
+                    XMVECTOR ex, XMVECTOR ey, XMVECTOR ez,
+                    XMVECTOR * pOutside, XMVECTOR * pInside)
+{
+    XMVECTOR const allTrue = XMVectorTrueInt();
+    XMVECTOR       outside = XMVectorFalseInt();
+    XMVECTOR       inside  = allTrue;
+
+    for (int i = 0; i < planes.count; ++i)
+    {
+        XMVECTOR distance = XMVectorMultiplyAdd(planes.a[i], cx,
+                                                XMVectorMultiplyAdd(planes.b[i], cy,
+                                                                    XMVectorMultiplyAdd(planes.c[i], cz, planes.d[i])));
+        XMVECTOR radius = XMVectorMultiplyAdd(planes.absA[i], ex,
+                                              XMVectorMultiplyAdd(planes.absB[i], ey, planes.absC[i] * ez));
+        outside = XMVectorOrInt(outside, XMVectorGreater(distance, radius));
+        inside  = XMVectorAndInt(inside, XMVectorLess(distance, XMVectorNegate(radius)));
+        if (XMVector4EqualInt(outside, allTrue))
+            break;
+    }
+
+    *pOutside = outside;
+    *pInside  = inside;
+}
+
+// Classifies the 4 spheres starting at i
+void ClassifySphereBounds4(SplatPlanes const & planes, Dxx::SphereBounds const & spheres, size_t i,
+                           XMVECTOR * pOutside, XMVECTOR * pInside)
+{
+    ClassifySpheres4(planes,
+                     Load4(spheres.x, i, spheres.count),
+                     Load4(spheres.y, i, spheres.count),
+                     Load4(spheres.z, i, spheres.count),
+                     Load4(spheres.radius, i, spheres.count),
+                     pOutside, pInside);
+}
+
+// Classifies the 4 boxes starting at i
+void ClassifyBoxBounds4(SplatPlanes const & planes, Dxx::BoxBounds const & boxes, size_t i,
+                        XMVECTOR * pOutside, XMVECTOR * pInside)
+{
+    XMVECTOR const half = XMVectorReplicate(0.5f);
+
+    XMVECTOR minX = Load4(boxes.minX, i, boxes.count);
+    XMVECTOR minY = Load4(boxes.minY, i, boxes.count);
+    XMVECTOR minZ = Load4(boxes.minZ, i, boxes.count);
+    XMVECTOR maxX = Load4(boxes.maxX, i, boxes.count);
+    XMVECTOR maxY = Load4(boxes.maxY, i, boxes.count);
+    XMVECTOR maxZ = Load4(boxes.maxZ, i, boxes.count);
+
+    ClassifyBoxes4(planes,
+                   (minX + maxX) * half, (minY + maxY) * half, (minZ + maxZ) * half,
+                   (maxX - minX) * half, (maxY - minY) * half, (maxZ - minZ) * half,
+                   pOutside, pInside);
+}
+
+// Classifies a range of objects 4 at a time
+template <typename Bounds, typename Classify4>
+void Classify(SplatPlanes const & planes, Bounds const & bounds, Classify4 classify4,
+              size_t begin, size_t end, uint8_t * pResults)
+{
+    for (size_t i = begin; i < end; i += 4)
+    {
+        XMVECTOR outside;
+        XMVECTOR inside;
+        classify4(planes, bounds, i, &outside, &inside);
+
+        uint32_t outsideBits = LaneBits(outside);
+        uint32_t insideBits  = LaneBits(inside);
+        size_t   n = std::min<size_t>(end - i, 4);
+        for (size_t j = 0; j < n; ++j)
+        {
+            if (outsideBits & (1u << j))
+                pResults[i + j] = Dxx::CULL_OUTSIDE;
+            else if (insideBits & (1u << j))
+                pResults[i + j] = Dxx::CULL_INSIDE;
+            else
+                pResults[i + j] = Dxx::CULL_INTERSECTING;
+        }
+    }
+}
+
+// Culls a range of objects 4 at a time. The range must begin on a multiple of 32.
+template <typename Bounds, typename Classify4>
+void Cull(SplatPlanes const & planes, Bounds const & bounds, Classify4 classify4,
+          size_t begin, size_t end, uint32_t * pVisible)
+{
+    assert(begin % 32 == 0);
+
+    for (size_t w = begin; w < end; w += 32)
+    {
+        size_t   n    = std::min<size_t>(end - w, 32);
+        uint32_t bits = 0;
+        for (size_t j = 0; j < n; j += 4)
+        {
+            XMVECTOR outside;
+            XMVECTOR inside;
+            classify4(planes, bounds, w + j, &outside, &inside);
+            bits |= (~LaneBits(outside) & 0xfu) << j;
+        }
+        if (n < 32)
+            bits &= (1u << n) - 1;
+        pVisible[w / 32] = bits;
+    }
+}
+
+// Returns true if an object is outside of any plane, testing the plane that rejected it last first.
+// isOutsidePlane(plane) returns true if the object is outside of the plane.
+template <typename IsOutsidePlane>
+bool IsOutsideCoherent(Dxx::CullingFrustum const & frustum,
+                       IsOutsidePlane              isOutsidePlane,
+                       uint8_t &                   lastPlane,
+                       uint64_t &                  planeTests)
+{
+    int const first = lastPlane;
+    if (first < frustum.size())
+    {
+        ++planeTests;
+        if (isOutsidePlane(frustum.plane(first)))
+            return true;
+    }
+
+    for (int i = 0; i < frustum.size(); ++i)
+    {
+        if (i == first)
+            continue;
+
+        ++planeTests;
+        if (isOutsidePlane(frustum.plane(i)))
+        {
+            lastPlane = uint8_t(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Culls objects in parallel into a bitset. isOutside(i, planeTests) returns true if object i is outside.
+template <typename IsOutside>
+void CullCoherent(size_t count, IsOutside isOutside, uint32_t * pVisible, Dxx::CullStats * pStats)
+{
+    std::atomic<uint64_t> planeTests(0);
+
+    Dxx::ParallelFor(count, GRAIN, [&] (size_t begin, size_t end) {
+                         uint64_t tests = 0;
+                         for (size_t w = begin; w < end; w += 32)
+                         {
+                             size_t   n    = std::min<size_t>(end - w, 32);
+                             uint32_t bits = 0;
+                             for (size_t j = 0; j < n; ++j)
+                             {
+                                 if (!isOutside(w + j, tests))
+                                     bits |= 1u << j;
+                             }
+                             pVisible[w / 32] = bits;
+                         }
+                         planeTests += tests;
+                     });
+
+    pStats->boundsTested = count;
+    pStats->planeTests   = planeTests;
+}
+} // anonymous namespace
+
+namespace Dxx
+{
+//! @param	frustum		A frustum, such as the one returned by Camera::viewFrustum()
+
+CullingFrustum::CullingFrustum(Frustum const & frustum)
+    : count_(0)
+{
+    for (int side : { Frustum::LEFT_SIDE, Frustum::RIGHT_SIDE, Frustum::TOP_SIDE, Frustum::BOTTOM_SIDE,
+                      Frustum::FRONT_SIDE, Frustum::BACK_SIDE })
+    {
+        Plane const & p = frustum.sides_[side];
+        add(XMFLOAT4(p.n_.x_, p.n_.y_, p.n_.z_, p.d_));
+    }
+}
+
+//! The planes are extracted from the matrix in the same way as Camera::viewFrustum().
+//!
+//! @param	m	A view-projection matrix, such as the one returned by Camera::viewProjectionMatrix()
+
+CullingFrustum::CullingFrustum(XMFLOAT4X4 const & m)
+    : count_(0)
+{
+    add(XMFLOAT4(-m._14 - m._11, -m._24 - m._21, -m._34 - m._31, -m._44 - m._41));  // Left
+    add(XMFLOAT4(-m._14 + m._11, -m._24 + m._21, -m._34 + m._31, -m._44 + m._41));  // Right
+    add(XMFLOAT4(-m._14 + m._12, -m._24 + m._22, -m._34 + m._32, -m._44 + m._42));  // Top
+    add(XMFLOAT4(-m._14 - m._12, -m._24 - m._22, -m._34 - m._32, -m._44 - m._42));  // Bottom
+    add(XMFLOAT4(-m._13,         -m._23,         -m._33,         -m._43));          // Front
+    add(XMFLOAT4(-m._14 + m._13, -m._24 + m._23, -m._34 + m._33, -m._44 + m._43));  // Back
+}
+
+//! @param	plane	The plane to add. Its normal must point out of the volume. It does not need to be normalized.
+
+void CullingFrustum::add(XMFLOAT4 const & plane)
+{
+    assert(count_ < MAX_PLANES);
+
+    XMVECTOR p_simd = XMPlaneNormalize(XMLoadFloat4(&plane));
+    XMStoreFloat4(&planes_[count_], p_simd);
+    ++count_;
+}
+
+//! @param	frustum		Culling volume
+//! @param	spheres		Bounding spheres
+//! @param	pResults	Where to store the classification of each sphere (a CullResult value). The array must have room for
+//!						@a spheres.count values.
+
+void ClassifySpheres(CullingFrustum const & frustum, SphereBounds const & spheres, uint8_t * pResults)
+{
+    SplatPlanes planes(frustum);
+    ParallelFor(spheres.count, GRAIN, [&] (size_t begin, size_t end) {
+                    Classify(planes, spheres, ClassifySphereBounds4, begin, end, pResults);
+                });
+}
+
+//! @param	frustum		Culling volume
+//! @param	boxes		Bounding boxes
+//! @param	pResults	Where to store the classification of each box (a CullResult value). The array must have room for
+//!						@a boxes.count values.
+//!
+//! @note	A box may be classified as intersecting even though it is entirely outside, if it is near a corner of the
+//!			culling volume.
+
+void ClassifyBoxes(CullingFrustum const & frustum, BoxBounds const & boxes, uint8_t * pResults)
+{
+    SplatPlanes planes(frustum);
+    ParallelFor(boxes.count, GRAIN, [&] (size_t begin, size_t end) {
+                    Classify(planes, boxes, ClassifyBoxBounds4, begin, end, pResults);
+                });
+}
+
+//! @param	frustum		Culling volume
+//! @param	spheres		Bounding spheres
+//! @param	pVisible	Where to store the visibility bitset. Bit (i % 32) of word (i / 32) is set if sphere i is at least
+//!						partially inside. The array must have room for VisibilityBitsetSize(@a spheres.count) words.
+
+void CullSpheres(CullingFrustum const & frustum, SphereBounds const & spheres, uint32_t * pVisible)
+{
+    SplatPlanes planes(frustum);
+    ParallelFor(spheres.count, GRAIN, [&] (size_t begin, size_t end) {
+                    Cull(planes, spheres, ClassifySphereBounds4, begin, end, pVisible);
+                });
+}
+
+//! @param	frustum		Culling volume
+//! @param	boxes		Bounding boxes
+//! @param	pVisible	Where to store the visibility bitset. Bit (i % 32) of word (i / 32) is set if box i is at least
+//!						partially inside. The array must have room for VisibilityBitsetSize(@a boxes.count) words.
+
+void CullBoxes(CullingFrustum const & frustum, BoxBounds const & boxes, uint32_t * pVisible)
+{
+    SplatPlanes planes(frustum);
+    ParallelFor(boxes.count, GRAIN, [&] (size_t begin, size_t end) {
+                    Cull(planes, boxes, ClassifyBoxBounds4, begin, end, pVisible);
+                });
+}
+
+//! @param	pVisible	Visibility bitset
+//! @param	count		Number of objects
+//! @param	pIndexes	Where to store the indexes of the visible objects, in increasing order. The array must have room
+//!						for @a count indexes.
+//!
+//! @return		Number of indexes stored
+
+size_t CompactVisible(uint32_t const * pVisible, size_t count, uint32_t * pIndexes)
+{
+    uint32_t * pStart = pIndexes;
+
+    for (size_t w = 0; w < VisibilityBitsetSize(count); ++w)
+    {
+        for (uint32_t bits = pVisible[w]; bits != 0; bits &= bits - 1)
+        {
+            *pIndexes++ = uint32_t(w * 32 + LowestBit(bits));
+        }
+    }
+
+    return size_t(pIndexes - pStart);
+}
+
+//! @param	frustum		Culling volume
+//! @param	spheres		Bounding spheres
+//! @param	pVisible	Where to store the visibility bitset. Bit (i % 32) of word (i / 32) is set if sphere i is at least
+//!						partially inside. The array must have room for VisibilityBitsetSize(@a spheres.count) words.
+
+void CoherentCuller::cullSpheres(CullingFrustum const & frustum, SphereBounds const & spheres, uint32_t * pVisible)
+{
+    Prepare(spheres.count);
+    uint8_t * pLastPlanes = lastPlanes_.data();
+
+    CullCoherent(spheres.count,
+                 [&] (size_t i, uint64_t & planeTests) {
+                     float x = spheres.x[i];
+                     float y = spheres.y[i];
+                     float z = spheres.z[i];
+                     float r = spheres.radius[i];
+                     return IsOutsideCoherent(frustum,
+                                              [=] (XMFLOAT4 const & p) { return p.x * x + p.y * y + p.z * z + p.w > r; },
+                                              pLastPlanes[i],
+                                              planeTests);
+                 },
+                 pVisible,
+                 &stats_);
+}
+
+//! @param	frustum		Culling volume
+//! @param	boxes		Bounding boxes
+//! @param	pVisible	Where to store the visibility bitset. Bit (i % 32) of word (i / 32) is set if box i is at least
+//!						partially inside. The array must have room for VisibilityBitsetSize(@a boxes.count) words.
+
+void CoherentCuller::cullBoxes(CullingFrustum const & frustum, BoxBounds const & boxes, uint32_t * pVisible)
+{
+    Prepare(boxes.count);
+    uint8_t * pLastPlanes = lastPlanes_.data();
+
+    CullCoherent(boxes.count,
+                 [&] (size_t i, uint64_t & planeTests) {
+                     float cx = (boxes.minX[i] + boxes.maxX[i]) * 0.5f;
+                     float cy = (boxes.minY[i] + boxes.maxY[i]) * 0.5f;
+                     float cz = (boxes.minZ[i] + boxes.maxZ[i]) * 0.5f;
+                     float ex = (boxes.maxX[i] - boxes.minX[i]) * 0.5f;
+                     float ey = (boxes.maxY[i] - boxes.minY[i]) * 0.5f;
+                     float ez = (boxes.maxZ[i] - boxes.minZ[i]) * 0.5f;
+                     return IsOutsideCoherent(frustum,
+                                              [=] (XMFLOAT4 const & p) {
+                                                  return p.x * cx + p.y * cy + p.z * cz + p.w >
+                                                         fabsf(p.x) * ex + fabsf(p.y) * ey + fabsf(p.z) * ez;
+                                              },
+                                              pLastPlanes[i],
+                                              planeTests);
+                 },
+                 pVisible,
+                 &stats_);
+}
+
+void CoherentCuller::Prepare(size_t count)
+{
+    if (lastPlanes_.size() != count)
+        lastPlanes_.assign(count, NO_PLANE);
+}
+} // namespace Dxx
@@ -0,0 +1,149 @@
+#include "DepthPyramid.h"
+
+#include "Camera.h"
+#include "ParallelFor.h"
+#include "ScreenBounds.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+size_t constexpr BUILD_GRAIN = 16;      // Number of rows reduced by a thread at a time
+size_t constexpr TEST_GRAIN  = 4096;    // Number of boxes tested by a thread at a time (must be a multiple of 32)
+} // anonymous namespace
+
+namespace Dxx
+{
+//! @param	pDepth	Depth buffer (z / w, with row 0 at the top)
+//! @param	width	Width of the depth buffer
+//! @param	height	Height of the depth buffer
+
+void DepthPyramid::build(float const * pDepth, int width, int height)
+{
+    assert(width > 0 && height > 0);
+
+    // Determine the number of levels and reuse the existing storage where possible
+
+    int count = 1;
+    for (int w = width, h = height; w > 1 || h > 1; w = (w + 1) / 2, h = (h + 1) / 2)
+    {
+        ++count;
+    }
+    levels_.resize(count);
+
+    levels_[0].width  = width;
+    levels_[0].height = height;
+    levels_[0].depth.assign(pDepth, pDepth + size_t(width) * height);
+
+    for (int i = 1; i < count; ++i)
+    {
+        Level const & src = levels_[i - 1];
+        Level &       dst = levels_[i];
+        dst.width  = (src.width + 1) / 2;
+        dst.height = (src.height + 1) / 2;
+        dst.depth.resize(size_t(dst.width) * dst.height);
+
+        // Each texel is the farthest of the 2x2 texels below it. At an odd edge, the last texel only covers 1 texel.
+        ParallelFor(dst.height, BUILD_GRAIN, [&src, &dst] (size_t begin, size_t end) {
+                        for (size_t y = begin; y < end; ++y)
+                        {
+                            size_t        y1    = std::min(2 * y + 1, size_t(src.height) - 1);
+                            float const * pRow0 = &src.depth[2 * y * src.width];
+                            float const * pRow1 = &src.depth[y1 * src.width];
+                            float *       pOut  = &dst.depth[y * dst.width];
+                            for (int x = 0; x < dst.width; ++x)
+                            {
+                                int x0 = 2 * x;
+                                int x1 = std::min(x0 + 1, src.width - 1);
+                                pOut[x] = std::max(std::max(pRow0[x0], pRow0[x1]), std::max(pRow1[x0], pRow1[x1]));
+                            }
+                        }
+                    });
+    }
+}
+
+//! @param	camera		The camera that the boxes are viewed from
+//! @param	boxes		Bounds of the objects
+//! @param	pVisible	Visibility bitset. On input, only the boxes whose bits are set are tested. On output, the bits
+//!						of the boxes that are completely occluded are cleared.
+
+void DepthPyramid::testBoxes(Camera const & camera, BoxBounds const & boxes, uint32_t * pVisible) const
+{
+    testBoxes(camera.viewProjectionMatrix(), boxes, pVisible);
+}
+
+//! @param	viewProjection	The view-projection matrix that the depth buffer was rendered with
+//! @param	boxes			Bounds of the objects
+//! @param	pVisible		Visibility bitset. On input, only the boxes whose bits are set are tested. On output, the
+//!							bits of the boxes that are completely occluded are cleared.
+
+void DepthPyramid::testBoxes(XMFLOAT4X4 const & viewProjection, BoxBounds const & boxes, uint32_t * pVisible) const
+{
+    if (levels_.empty())
+        return;
+
+    XMMATRIX viewProjection_simd = XMLoadFloat4x4(&viewProjection);
+
+    ParallelFor(boxes.count, TEST_GRAIN, [&] (size_t begin, size_t end) {
+                    for (size_t w = begin / 32; w < VisibilityBitsetSize(end); ++w)
+                    {
+                        uint32_t bits = pVisible[w];
+                        for (uint32_t j = 0; j < 32; ++j)
+                        {
+                            size_t i = w * 32 + j;
+                            if (i >= end || !(bits & (1u << j)))
+                                continue;
+
+                            if (!IsVisible(viewProjection_simd,
+                                           XMFLOAT3(boxes.minX[i], boxes.minY[i], boxes.minZ[i]),
+                                           XMFLOAT3(boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i])))
+                            {
+                                bits &= ~(1u << j);
+                            }
+                        }
+                        pVisible[w] = bits;
+                    }
+                });
+}
+
+bool DepthPyramid::IsVisible(FXMMATRIX viewProjection, XMFLOAT3 const & min, XMFLOAT3 const & max) const
+{
+    Level const & base = levels_[0];
+
+    ScreenBounds bounds;
+    if (!ProjectBox(viewProjection, min, max, float(base.width), float(base.height), &bounds))
+        return true;    // The box crosses the near plane, so assume it is visible
+
+    if (bounds.maxX < 0.0f || bounds.minX >= float(base.width) || bounds.maxY < 0.0f || bounds.minY >= float(base.height))
+        return false;   // The box is off the screen
+
+    // The texels overlapped by the box at level 0 (inclusive)
+    int x0 = std::max(int(floorf(bounds.minX)), 0);
+    int x1 = std::min(int(floorf(bounds.maxX)), base.width - 1);
+    int y0 = std::max(int(floorf(bounds.minY)), 0);
+    int y1 = std::min(int(floorf(bounds.maxY)), base.height - 1);
+
+    // Find the first level at which the box overlaps at most 2x2 texels. The top level is 1x1, so there always is one.
+    int level = 0;
+    while ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)
+    {
+        ++level;
+    }
+    assert(level < int(levels_.size()));
+
+    Level const & texels = levels_[level];
+    int           tx0 = x0 >> level;
+    int           tx1 = x1 >> level;
+    int           ty0 = y0 >> level;
+    int           ty1 = y1 >> level;
+    float const * pRow0 = &texels.depth[size_t(ty0) * texels.width];
+    float const * pRow1 = &texels.depth[size_t(ty1) * texels.width];
+    float         farthest = std::max(std::max(pRow0[tx0], pRow0[tx1]), std::max(pRow1[tx0], pRow1[tx1]));
+
+    return bounds.minZ <= farthest;
+}
+} // namespace Dxx
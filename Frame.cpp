@@ -17,15 +17,11 @@ namespace Dxx
 Frame::Frame(XMFLOAT3 const & translation,
              XMFLOAT4 const & rotation,
              XMFLOAT3 const & scale /* = XMFLOAT3( 1.0f, 1.0f, 1.0f )*/)
+    : t_(translation)
+    , r_(rotation)
+    , s_(scale)
 {
-    XMVECTORF32 q_simd{ rotation.x, rotation.y, rotation.z, rotation.w };
-    XMMATRIX    t_simd = XMMatrixTranslation(translation.x, translation.y, translation.z);
-    XMMATRIX    r_simd = XMMatrixRotationQuaternion(q_simd);
-    XMMATRIX    s_simd = XMMatrixScaling(scale.x, scale.y, scale.z);
-
-    XMMATRIX m_simd = s_simd * r_simd * t_simd;
-
-    XMStoreFloat4x4(&m_, m_simd);
+    Compose();
 }
 
 //! M' =  T * M
@@ -34,12 +30,11 @@ Frame::Frame(XMFLOAT3 const & translation,
 
 Frame & Frame::translate(XMFLOAT3 const & t)
 {
-    XMMATRIX m_simd = XMLoadFloat4x4(&m_);
-    XMMATRIX t_simd = XMMatrixTranslation(t.x, t.y, t.z);
+    // T * S * R * T0 = S * R * T', where T' translates by t0 + (t * S * R)
 
-    m_simd = t_simd * m_simd;
-
-    XMStoreFloat4x4(&m_, m_simd);
+    XMVECTOR t_simd = XMVector3Rotate(XMLoadFloat3(&t) * XMLoadFloat3(&s_), XMLoadFloat4(&r_));
+    XMStoreFloat3(&t_, XMLoadFloat3(&t_) + t_simd);
+    Compose();
 
     return *this;
 }
@@ -50,13 +45,22 @@ Frame & Frame::translate(XMFLOAT3 const & t)
 
 Frame & Frame::rotate(XMFLOAT4 const & r)
 {
-    XMMATRIX    m_simd = XMLoadFloat4x4(&m_);
     XMVECTORF32 q_simd{ r.x, r.y, r.z, r.w };
 
-    XMMATRIX r_simd = XMMatrixRotationQuaternion(q_simd);
-    m_simd = r_simd * m_simd;
-
-    XMStoreFloat4x4(&m_, m_simd);
+    if (s_.x == s_.y && s_.y == s_.z)
+    {
+        // A uniform scale commutes with the rotation, so R * S * R0 * T = S * (R * R0) * T
+        XMStoreFloat4(&r_, XMQuaternionNormalize(XMQuaternionMultiply(q_simd, XMLoadFloat4(&r_))));
+        Compose();
+    }
+    else
+    {
+        // The result is not necessarily a combination of a scale, rotation, and translation, so the matrix is computed
+        // and then decomposed.
+        XMMATRIX m_simd = XMMatrixRotationQuaternion(q_simd) * XMLoadFloat4x4(&m_);
+        XMStoreFloat4x4(&m_, m_simd);
+        Decompose();
+    }
 
     return *this;
 }
@@ -71,12 +75,8 @@ Frame & Frame::scale(XMFLOAT3 const & s)
     assert(!MyMath::IsCloseToZero(s.y));
     assert(!MyMath::IsCloseToZero(s.z));
 
-    XMMATRIX m_simd = XMLoadFloat4x4(&m_);
-    XMMATRIX s_simd = XMMatrixScaling(s.x, s.y, s.z);
-
-    m_simd = s_simd * m_simd;
-
-    XMStoreFloat4x4(&m_, m_simd);
+    s_ = XMFLOAT3(s.x * s_.x, s.y * s_.y, s.z * s_.z);
+    Compose();
 
     return *this;
 }
@@ -86,32 +86,11 @@ Frame & Frame::scale(XMFLOAT3 const & s)
 
 void Frame::setTranslation(XMFLOAT3 const & t)
 {
-    XMVECTOR t_simd(XMLoadFloat3(&t));
-    XMMATRIX m_simd(XMLoadFloat4x4(&m_));
-
-    XMVECTOR s_simd;
-    XMVECTOR r_simd;
-    XMVECTOR old_t_simd;
-    XMMatrixDecompose(&s_simd, &r_simd, &old_t_simd, m_simd);
-
-    // Replace translation
-    m_simd = XMMatrixScalingFromVector(s_simd) * XMMatrixRotationQuaternion(r_simd) * XMMatrixTranslationFromVector(t_simd);
-
-    XMStoreFloat4x4(&m_, m_simd);
-}
-
-XMFLOAT3 Frame::translation() const
-{
-    XMMATRIX m_simd(XMLoadFloat4x4(&m_));
-
-    XMVECTOR s_simd;
-    XMVECTOR q_simd;
-    XMVECTOR t_simd;
-    XMMatrixDecompose(&s_simd, &q_simd, &t_simd, m_simd);
-
-    XMFLOAT3 t;
-    XMStoreFloat3(&t, t_simd);
-    return t;
+    // Only the last row of the matrix changes
+    t_     = t;
+    m_._41 = t.x;
+    m_._42 = t.y;
+    m_._43 = t.z;
 }
 
 //!
@@ -119,65 +98,23 @@ XMFLOAT3 Frame::translation() const
 
 void Frame::setOrientation(XMFLOAT3X3 const & r)
 {
-    XMMATRIX r_simd(XMLoadFloat3x3(&r));
-    XMMATRIX m_simd(XMLoadFloat4x4(&m_));
-
-    XMVECTOR s_simd;
-    XMVECTOR old_r_simd;
-    XMVECTOR t_simd;
-    XMMatrixDecompose(&s_simd, &old_r_simd, &t_simd, m_simd);
-
-    // Replace rotation
-    m_simd = XMMatrixScalingFromVector(s_simd) * r_simd * XMMatrixTranslationFromVector(t_simd);
-
-    XMStoreFloat4x4(&m_, m_simd);
+    XMStoreFloat4(&r_, XMQuaternionRotationMatrix(XMLoadFloat3x3(&r)));
+    Compose();
 }
 
 //!
 //! @param	r	Orientation value.
 
-inline void Frame::setOrientation(XMFLOAT4 const & r)
-{
-    XMVECTOR r_simd(XMLoadFloat4(&r));
-    XMMATRIX m_simd(XMLoadFloat4x4(&m_));
-
-    XMVECTOR s_simd;
-    XMVECTOR old_r_simd;
-    XMVECTOR t_simd;
-    XMMatrixDecompose(&s_simd, &old_r_simd, &t_simd, m_simd);
-
-    // Replace rotation
-    m_simd = XMMatrixScalingFromVector(s_simd) * XMMatrixRotationQuaternion(r_simd) * XMMatrixTranslationFromVector(t_simd);
-
-    XMStoreFloat4x4(&m_, m_simd);
-}
-
-inline XMFLOAT4 Frame::orientation() const
+void Frame::setOrientation(XMFLOAT4 const & r)
 {
-    XMMATRIX m_simd(XMLoadFloat4x4(&m_));
-
-    XMVECTOR s_simd;
-    XMVECTOR r_simd;
-    XMVECTOR t_simd;
-    XMMatrixDecompose(&s_simd, &r_simd, &t_simd, m_simd);
-
-    XMFLOAT4 r;
-    XMStoreFloat4(&r, r_simd);
-    return r;
+    r_ = r;
+    Compose();
 }
 
 XMFLOAT3X3 Frame::orientationMatrix() const
 {
-    XMMATRIX m_simd(XMLoadFloat4x4(&m_));
-
-    XMVECTOR s_simd;
-    XMVECTOR q_simd;
-    XMVECTOR t_simd;
-    XMMatrixDecompose(&s_simd, &q_simd, &t_simd, m_simd);
-    XMMATRIX r_simd = XMMatrixRotationQuaternion(q_simd);
-
     XMFLOAT3X3 r;
-    XMStoreFloat3x3(&r, r_simd);
+    XMStoreFloat3x3(&r, XMMatrixRotationQuaternion(XMLoadFloat4(&r_)));
     return r;
 }
 
@@ -190,43 +127,15 @@ void Frame::setScale(XMFLOAT3 const & s)
     assert(!MyMath::IsCloseToZero(s.y));
     assert(!MyMath::IsCloseToZero(s.z));
 
-    XMVECTOR s_simd(XMLoadFloat3(&s));
-    XMMATRIX m_simd(XMLoadFloat4x4(&m_));
-
-    XMVECTOR old_s_simd;
-    XMVECTOR r_simd;
-    XMVECTOR t_simd;
-    XMMatrixDecompose(&old_s_simd, &r_simd, &t_simd, m_simd);
-
-    // Replace scale
-    m_simd = XMMatrixScalingFromVector(s_simd) * XMMatrixRotationQuaternion(r_simd) * XMMatrixTranslationFromVector(t_simd);
-
-    XMStoreFloat4x4(&m_, m_simd);
-}
-
-XMFLOAT3 Frame::scale() const
-{
-    XMMATRIX m_simd(XMLoadFloat4x4(&m_));
-
-    XMVECTOR s_simd;
-    XMVECTOR r_simd;
-    XMVECTOR t_simd;
-    XMMatrixDecompose(&s_simd, &r_simd, &t_simd, m_simd);
-
-    XMFLOAT3 s;
-    XMStoreFloat3(&s, s_simd);
-    return s;
-}
-
-inline XMFLOAT4X4 Frame::transformation() const
-{
-    return m_;
+    s_ = s;
+    Compose();
 }
 
+//! The matrix is decomposed into a translation, orientation, and scale.
 //!
 //! @param	m	Value to set the transformation matrix to.
 
-inline void Frame::setTransformation(XMFLOAT4X4 const & m)
+void Frame::setTransformation(XMFLOAT4X4 const & m)
 {
     // Make sure that none of the scales are 0
 
@@ -239,38 +148,52 @@ inline void Frame::setTransformation(XMFLOAT4X4 const & m)
     //	assert( m._43 == 1.f );
 
     m_ = m;
+    Decompose();
 }
 
-inline XMFLOAT3 Frame::xAxis() const
+XMFLOAT3 Frame::xAxis() const
 {
-    XMVECTORF32 v_simd{ m_._11, m_._12, m_._13, 1.0f };
+    XMFLOAT3 axis;
+    XMStoreFloat3(&axis, XMVector3Rotate(XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), XMLoadFloat4(&r_)));
+    return axis;
+}
 
-    XMVECTOR axis_simd = XMVector3Normalize(v_simd);
+XMFLOAT3 Frame::yAxis() const
+{
+    XMFLOAT3 axis;
+    XMStoreFloat3(&axis, XMVector3Rotate(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), XMLoadFloat4(&r_)));
+    return axis;
+}
 
-    XMFLOAT4 axis;
-    XMStoreFloat4(&axis, axis_simd);
-    return { axis.x, axis.y, axis.z };
+XMFLOAT3 Frame::zAxis() const
+{
+    XMFLOAT3 axis;
+    XMStoreFloat3(&axis, XMVector3Rotate(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMLoadFloat4(&r_)));
+    return axis;
 }
 
-inline XMFLOAT3 Frame::yAxis() const
+void Frame::Compose()
 {
-    XMVECTORF32 v_simd{ m_._21, m_._22, m_._23, 1.0f };
+    // S * R * T is R with its rows scaled and the translation in the last row
 
-    XMVECTOR axis_simd = XMVector3Normalize(v_simd);
+    XMMATRIX m_simd = XMMatrixRotationQuaternion(XMLoadFloat4(&r_));
+    m_simd.r[0] = m_simd.r[0] * XMVectorReplicate(s_.x);
+    m_simd.r[1] = m_simd.r[1] * XMVectorReplicate(s_.y);
+    m_simd.r[2] = m_simd.r[2] * XMVectorReplicate(s_.z);
+    m_simd.r[3] = XMVectorSet(t_.x, t_.y, t_.z, 1.0f);
 
-    XMFLOAT4 axis;
-    XMStoreFloat4(&axis, axis_simd);
-    return { axis.x, axis.y, axis.z };
+    XMStoreFloat4x4(&m_, m_simd);
 }
 
-inline XMFLOAT3 Frame::zAxis() const
+void Frame::Decompose()
 {
-    XMVECTORF32 v_simd{ m_._31, m_._32, m_._33, 1.0f };
-
-    XMVECTOR axis_simd = XMVector3Normalize(v_simd);
+    XMVECTOR s_simd;
+    XMVECTOR r_simd;
+    XMVECTOR t_simd;
+    XMMatrixDecompose(&s_simd, &r_simd, &t_simd, XMLoadFloat4x4(&m_));
 
-    XMFLOAT4 axis;
-    XMStoreFloat4(&axis, axis_simd);
-    return { axis.x, axis.y, axis.z };
+    XMStoreFloat3(&s_, s_simd);
+    XMStoreFloat4(&r_, r_simd);
+    XMStoreFloat3(&t_, t_simd);
 }
 } // namespace Dxx
@@ -0,0 +1,130 @@
+#include "InstanceCompactor.h"
+
+#include "Frame.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+using namespace DirectX;
+
+namespace
+{
+size_t constexpr GRAIN = 4096;  // Number of objects in a chunk (must be a multiple of 32)
+
+// Calls f(i) for each object in [begin, end) whose bit is set
+template <typename Function>
+void ForEachVisible(uint32_t const * pVisible, size_t begin, size_t end, Function f)
+{
+    for (size_t w = begin; w < end; w += 32)
+    {
+        uint32_t bits = pVisible[w / 32];
+        if (bits == 0)
+            continue;
+
+        size_t n = std::min<size_t>(end - w, 32);
+        for (size_t j = 0; j < n; ++j)
+        {
+            if (bits & (1u << j))
+                f(w + j);
+        }
+    }
+}
+
+// Writes the transpose of the upper 3 columns of a matrix without polluting the cache
+void StreamInstance(XMFLOAT4X4 const & m, XMFLOAT3X4A * pInstance)
+{
+    XMMATRIX t_simd = XMMatrixTranspose(XMLoadFloat4x4(&m));
+#if defined(_XM_SSE_INTRINSICS_)
+    _mm_stream_ps(&pInstance->m[0][0], t_simd.r[0]);
+    _mm_stream_ps(&pInstance->m[1][0], t_simd.r[1]);
+    _mm_stream_ps(&pInstance->m[2][0], t_simd.r[2]);
+#else
+    XMStoreFloat4A(reinterpret_cast<XMFLOAT4A *>(&pInstance->m[0][0]), t_simd.r[0]);
+    XMStoreFloat4A(reinterpret_cast<XMFLOAT4A *>(&pInstance->m[1][0]), t_simd.r[1]);
+    XMStoreFloat4A(reinterpret_cast<XMFLOAT4A *>(&pInstance->m[2][0]), t_simd.r[2]);
+#endif
+}
+} // anonymous namespace
+
+namespace Dxx
+{
+//! The instances of mesh @e k are written to pInstances[pOffsets[k]] through pInstances[pOffsets[k + 1] - 1], so
+//! pOffsets[k] is the start instance location and pOffsets[k + 1] - pOffsets[k] is the instance count for mesh @e k.
+//!
+//! @param	pVisible	Visibility bitset
+//! @param	pFrames		Frame of each object
+//! @param	pMeshIds	Mesh id of each object (less than @a meshCount)
+//! @param	count		Number of objects
+//! @param	meshCount	Number of meshes
+//! @param	pInstances	Where to write the instances. The array must be 16-byte aligned and have room for the number
+//!						of visible objects.
+//! @param	pOffsets	Where to write the offset of each mesh's instances. The array must have room for
+//!						@a meshCount + 1 values.
+//!
+//! @return		The number of instances written
+
+size_t InstanceCompactor::compact(uint32_t const * pVisible,
+                                  Frame const *    pFrames,
+                                  uint32_t const * pMeshIds,
+                                  size_t           count,
+                                  uint32_t         meshCount,
+                                  XMFLOAT3X4A *    pInstances,
+                                  uint32_t *       pOffsets)
+{
+    assert((reinterpret_cast<uintptr_t>(pInstances) & 15) == 0);
+
+    // The objects are split into fixed chunks so that each chunk can write its instances of each mesh to its own
+    // range without synchronization. The chunks are handed out one at a time.
+
+    size_t const chunks = (count + GRAIN - 1) / GRAIN;
+    counts_.assign(chunks * meshCount, 0);
+
+    // Count the visible objects of each mesh in each chunk
+
+    ParallelFor(chunks, 1, [&] (size_t first, size_t last) {
+                    for (size_t c = first; c < last; ++c)
+                    {
+                        uint32_t * pCounts = &counts_[c * meshCount];
+                        ForEachVisible(pVisible, c * GRAIN, std::min(c * GRAIN + GRAIN, count), [&] (size_t i) {
+                                           assert(pMeshIds[i] < meshCount);
+                                           ++pCounts[pMeshIds[i]];
+                                       });
+                    }
+                });
+
+    // Replace the counts with the offsets of each chunk's instances of each mesh. The instances of a mesh are in the
+    // order of the chunks, so they are in the order of the objects.
+
+    uint32_t total = 0;
+    for (uint32_t k = 0; k < meshCount; ++k)
+    {
+        pOffsets[k] = total;
+        for (size_t c = 0; c < chunks; ++c)
+        {
+            uint32_t n = counts_[c * meshCount + k];
+            counts_[c * meshCount + k] = total;
+            total += n;
+        }
+    }
+    pOffsets[meshCount] = total;
+
+    // Write the instances
+
+    ParallelFor(chunks, 1, [&] (size_t first, size_t last) {
+                    for (size_t c = first; c < last; ++c)
+                    {
+                        uint32_t * pNext = &counts_[c * meshCount];
+                        ForEachVisible(pVisible, c * GRAIN, std::min(c * GRAIN + GRAIN, count), [&] (size_t i) {
+                                           StreamInstance(pFrames[i].transformation(), &pInstances[pNext[pMeshIds[i]]++]);
+                                       });
+                    }
+#if defined(_XM_SSE_INTRINSICS_)
+                    _mm_sfence();   // Streaming stores must be fenced before another thread reads them
+#endif
+                });
+
+    return total;
+}
+} // namespace Dxx
@@ -0,0 +1,151 @@
+#include "LodSelector.h"
+
+#include "Camera.h"
+#include "ParallelFor.h"
+#include "SimdLanes.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+
+using namespace DirectX;
+
+namespace
+{
+size_t constexpr GRAIN = 4096;  // Number of objects processed by a thread at a time (must be a multiple of 32)
+
+// Returns the projected sizes of the 4 spheres starting at i. If the eye is inside a sphere, its size is FLT_MAX.
+XMVECTOR ProjectedSizes4(Dxx::SphereBounds const & spheres, size_t i,
+                         FXMVECTOR ex, FXMVECTOR ey, FXMVECTOR ez, FXMVECTOR scale)
+{
+    XMVECTOR dx        = Dxx::Load4(spheres.x, i, spheres.count) - ex;
+    XMVECTOR dy        = Dxx::Load4(spheres.y, i, spheres.count) - ey;
+    XMVECTOR dz        = Dxx::Load4(spheres.z, i, spheres.count) - ez;
+    XMVECTOR r         = Dxx::Load4(spheres.radius, i, spheres.count);
+    XMVECTOR distance2 = XMVectorMultiplyAdd(dx, dx, XMVectorMultiplyAdd(dy, dy, dz * dz));
+    XMVECTOR size      = r * scale * XMVectorReciprocalSqrt(distance2);
+    return XMVectorSelect(size, XMVectorReplicate(FLT_MAX), XMVectorLessOrEqual(distance2, r * r));
+}
+} // anonymous namespace
+
+namespace Dxx
+{
+//! @param	camera			The camera
+//! @param	viewportHeight	Height of the viewport in pixels
+
+LodSelector::LodSelector(Camera const & camera, float viewportHeight)
+    : LodSelector(camera.projectionMatrix(), camera.position(), viewportHeight)
+{
+}
+
+//! @param	projection		The projection matrix
+//! @param	eye				Position of the camera
+//! @param	viewportHeight	Height of the viewport in pixels
+
+LodSelector::LodSelector(XMFLOAT4X4 const & projection, XMFLOAT3 const & eye, float viewportHeight)
+    : eye_(eye)
+    , scale_(projection._22 * viewportHeight * 0.5f)
+    , hysteresis_(0.1f)
+    , minimumSize_(0.0f)
+{
+}
+
+//! The size is the radius of the projected bounding sphere in pixels. If the camera is inside a bounding sphere, the
+//! size is FLT_MAX.
+//!
+//! @param	spheres		Bounding spheres
+//! @param	pSizes		Where to store the sizes. The array must have room for @a spheres.count values.
+
+void LodSelector::computeSizes(SphereBounds const & spheres, float * pSizes) const
+{
+    XMVECTOR const ex    = XMVectorReplicate(eye_.x);
+    XMVECTOR const ey    = XMVectorReplicate(eye_.y);
+    XMVECTOR const ez    = XMVectorReplicate(eye_.z);
+    XMVECTOR const scale = XMVectorReplicate(scale_);
+
+    ParallelFor(spheres.count, GRAIN, [&] (size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i += 4)
+                    {
+                        XMFLOAT4 sizes;
+                        XMStoreFloat4(&sizes, ProjectedSizes4(spheres, i, ex, ey, ez, scale));
+                        std::copy(&sizes.x, &sizes.x + std::min<size_t>(end - i, 4), pSizes + i);
+                    }
+                });
+}
+
+//! @param	spheres			Bounding spheres
+//! @param	pThresholds		Thresholds in pixels. pThresholds[k * @a spheres.count + i] is threshold @e k of object
+//!							@e i. The thresholds of each object must be in decreasing order. Unused thresholds should
+//!							be 0.
+//! @param	thresholdCount	Number of thresholds per object (at most 254)
+//! @param	pLods			The level of detail of each object. On input, the level selected in the previous frame (or
+//!							any value in the first frame). On output, the level selected in this frame.
+//! @param	pVisible		Visibility bitset. The bits of objects that are smaller than the minimum size are cleared.
+
+void LodSelector::select(SphereBounds const & spheres,
+                         float const *        pThresholds,
+                         int                  thresholdCount,
+                         uint8_t *            pLods,
+                         uint32_t *           pVisible) const
+{
+    assert(thresholdCount >= 0 && thresholdCount < 255);
+
+    XMVECTOR const ex      = XMVectorReplicate(eye_.x);
+    XMVECTOR const ey      = XMVectorReplicate(eye_.y);
+    XMVECTOR const ez      = XMVectorReplicate(eye_.z);
+    XMVECTOR const scale   = XMVectorReplicate(scale_);
+    XMVECTOR const lower   = XMVectorReplicate(1.0f - hysteresis_);
+    XMVECTOR const upper   = XMVectorReplicate(1.0f + hysteresis_);
+    XMVECTOR const minimum = XMVectorReplicate(minimumSize_);
+    XMVECTOR const one     = XMVectorSplatOne();
+    XMVECTOR const zero    = XMVectorZero();
+    size_t const   count   = spheres.count;
+
+    ParallelFor(count, GRAIN, [&] (size_t begin, size_t end) {
+                    for (size_t w = begin; w < end; w += 32)
+                    {
+                        size_t   n     = std::min<size_t>(end - w, 32);
+                        uint32_t large = 0;
+                        for (size_t j = 0; j < n; j += 4)
+                        {
+                            size_t   i    = w + j;
+                            size_t   m    = std::min<size_t>(n - j, 4);
+                            XMVECTOR size = ProjectedSizes4(spheres, i, ex, ey, ez, scale);
+
+                            // Without hysteresis, the level is the number of thresholds that the size is below. With
+                            // hysteresis, the level must be at least the number of thresholds that the size is clearly
+                            // below and at most the number that it is not clearly above, so the previous level is
+                            // clamped to that range.
+                            XMVECTOR low  = zero;
+                            XMVECTOR high = zero;
+                            for (int k = 0; k < thresholdCount; ++k)
+                            {
+                                XMVECTOR t = Load4(pThresholds + size_t(k) * count, i, count);
+                                low  += XMVectorSelect(zero, one, XMVectorLess(size, t * lower));
+                                high += XMVectorSelect(zero, one, XMVectorLess(size, t * upper));
+                            }
+
+                            XMFLOAT4 previous(0.0f, 0.0f, 0.0f, 0.0f);
+                            float *  p = &previous.x;
+                            for (size_t k = 0; k < m; ++k)
+                            {
+                                p[k] = float(pLods[i + k]);
+                            }
+
+                            XMFLOAT4 lods;
+                            XMStoreFloat4(&lods, XMVectorMin(XMVectorMax(XMLoadFloat4(&previous), low), high));
+                            float const * q = &lods.x;
+                            for (size_t k = 0; k < m; ++k)
+                            {
+                                pLods[i + k] = uint8_t(q[k]);
+                            }
+
+                            large |= LaneBits(XMVectorGreaterOrEqual(size, minimum)) << j;
+                        }
+                        if (n < 32)
+                            large |= ~((1u << n) - 1);
+                        pVisible[w / 32] &= large;
+                    }
+                });
+}
+} // namespace Dxx
@@ -0,0 +1,341 @@
+#include "LooseOctree.h"
+
+#include "Frame.h"
+
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace Dxx
+{
+//! @param	center		Center of the root's cell
+//! @param	halfSize	Half the size of the root's cell
+//! @param	maxDepth	Maximum depth of a node (the root's depth is 0)
+
+LooseOctree::LooseOctree(XMFLOAT3 const & center, float halfSize, int maxDepth /*= 8*/)
+    : freeNodes_(NONE)
+    , freeObjects_(NONE)
+    , nodeCount_(0)
+    , objectCount_(0)
+    , relinkCount_(0)
+    , maxDepth_(maxDepth)
+{
+    assert(halfSize > 0.0f);
+    assert(maxDepth >= 0);
+
+    AllocateNode(center, halfSize, NONE);
+}
+
+//! @param	frame	The object's frame of reference. Only the translation is used.
+//! @param	radius	Radius of the object's bounding sphere (centered at the frame's translation)
+//!
+//! @return		The object's id
+
+uint32_t LooseOctree::insert(Frame const & frame, float radius)
+{
+    return insert(frame.translation(), radius);
+}
+
+//! @param	position	Center of the object's bounding sphere
+//! @param	radius		Radius of the object's bounding sphere
+//!
+//! @return		The object's id
+
+uint32_t LooseOctree::insert(XMFLOAT3 const & position, float radius)
+{
+    uint32_t id;
+    if (freeObjects_ != NONE)
+    {
+        id           = freeObjects_;
+        freeObjects_ = objects_[id].next;
+    }
+    else
+    {
+        id = uint32_t(objects_.size());
+        objects_.emplace_back();
+    }
+
+    objects_[id].position = position;
+    objects_[id].radius   = radius;
+    Link(id, Find(position, radius));
+    ++objectCount_;
+    return id;
+}
+
+//! @param	id		The object's id
+//! @param	frame	The object's frame of reference. Only the translation is used.
+//! @param	radius	Radius of the object's bounding sphere (centered at the frame's translation)
+
+void LooseOctree::update(uint32_t id, Frame const & frame, float radius)
+{
+    update(id, frame.translation(), radius);
+}
+
+//! The object is only moved to another node if it no longer fits in the bounds of its current node (or if it is in the
+//! root, which it may have been put in because it was outside of the root's cell).
+//!
+//! @param	id			The object's id
+//! @param	position	Center of the object's bounding sphere
+//! @param	radius		Radius of the object's bounding sphere
+
+void LooseOctree::update(uint32_t id, XMFLOAT3 const & position, float radius)
+{
+    assert(id < objects_.size() && objects_[id].node != NONE);
+
+    objects_[id].position = position;
+    objects_[id].radius   = radius;
+
+    uint32_t old = objects_[id].node;
+    if (old != 0 && Fits(old, position, radius))
+        return;
+
+    uint32_t node = Find(position, radius);
+    if (node == old)
+        return;
+
+    Unlink(id);
+    Link(id, node);
+    Prune(old);
+    ++relinkCount_;
+}
+
+//! @param	id		The object's id
+
+void LooseOctree::remove(uint32_t id)
+{
+    assert(id < objects_.size() && objects_[id].node != NONE);
+
+    uint32_t node = objects_[id].node;
+    Unlink(id);
+    Prune(node);
+
+    objects_[id].node = NONE;
+    objects_[id].next = freeObjects_;
+    freeObjects_      = id;
+    --objectCount_;
+}
+
+//! @param	frustum		A view frustum, such as the one returned by Camera::viewFrustum()
+//! @param	visible		The ids of the visible objects are appended to this list
+
+void LooseOctree::cull(Frustum const & frustum, std::vector<uint32_t> & visible) const
+{
+    cull(CullingFrustum(frustum), visible);
+}
+
+//! @param	frustum		Culling volume
+//! @param	visible		The ids of the visible objects are appended to this list
+
+void LooseOctree::cull(CullingFrustum const & frustum, std::vector<uint32_t> & visible) const
+{
+    struct Entry
+    {
+        uint32_t node;
+        uint32_t planes;    // Planes that must still be tested
+    };
+
+    std::vector<Entry> stack;
+    stack.reserve(8 * maxDepth_ + 8);
+    stack.push_back({ 0, (1u << frustum.size()) - 1 });
+
+    while (!stack.empty())
+    {
+        Entry entry = stack.back();
+        stack.pop_back();
+
+        Node const & node = nodes_[entry.node];
+
+        // The root is not tested because it may contain objects that are outside of its bounds
+
+        if (entry.node != 0)
+        {
+            float const extent  = 2.0f * node.halfSize;
+            bool        outside = false;
+            for (int i = 0; i < frustum.size() && !outside; ++i)
+            {
+                if (!(entry.planes & (1u << i)))
+                    continue;
+
+                XMFLOAT4 const & p        = frustum.plane(i);
+                float            radius   = (fabsf(p.x) + fabsf(p.y) + fabsf(p.z)) * extent;
+                float            distance = p.x * node.center.x + p.y * node.center.y + p.z * node.center.z + p.w;
+                if (distance > radius)
+                    outside = true;
+                else if (distance < -radius)
+                    entry.planes &= ~(1u << i);
+            }
+            if (outside)
+                continue;
+
+            if (entry.planes == 0)
+            {
+                AppendSubtree(entry.node, visible);
+                continue;
+            }
+        }
+
+        // Test the objects in the node against the planes that the node is not completely inside of
+
+        for (uint32_t id = node.firstObject; id != NONE; id = objects_[id].next)
+        {
+            Object const & o       = objects_[id];
+            bool           outside = false;
+            for (int i = 0; i < frustum.size() && !outside; ++i)
+            {
+                if (!(entry.planes & (1u << i)))
+                    continue;
+
+                XMFLOAT4 const & p = frustum.plane(i);
+                outside = p.x * o.position.x + p.y * o.position.y + p.z * o.position.z + p.w > o.radius;
+            }
+            if (!outside)
+                visible.push_back(id);
+        }
+
+        for (uint32_t child : node.children)
+        {
+            if (child != NONE)
+                stack.push_back({ child, entry.planes });
+        }
+    }
+}
+
+uint32_t LooseOctree::Find(XMFLOAT3 const & position, float radius)
+{
+    uint32_t node = 0;
+
+    // Objects outside of the root's cell stay in the root
+    {
+        Node const & root = nodes_[0];
+        if (fabsf(position.x - root.center.x) > root.halfSize ||
+            fabsf(position.y - root.center.y) > root.halfSize ||
+            fabsf(position.z - root.center.z) > root.halfSize)
+        {
+            return 0;
+        }
+    }
+
+    // Descend into the cell containing the position until the object is too large for the next level
+
+    for (int depth = 0; depth < maxDepth_; ++depth)
+    {
+        XMFLOAT3 center    = nodes_[node].center;
+        float    childSize = nodes_[node].halfSize * 0.5f;
+        if (radius > childSize)
+            break;
+
+        int octant = ((position.x >= center.x) ? 1 : 0) |
+                     ((position.y >= center.y) ? 2 : 0) |
+                     ((position.z >= center.z) ? 4 : 0);
+        uint32_t child = nodes_[node].children[octant];
+        if (child == NONE)
+        {
+            XMFLOAT3 childCenter((octant & 1) ? center.x + childSize : center.x - childSize,
+                                 (octant & 2) ? center.y + childSize : center.y - childSize,
+                                 (octant & 4) ? center.z + childSize : center.z - childSize);
+            child = AllocateNode(childCenter, childSize, node);
+            nodes_[node].children[octant] = child;
+            ++nodes_[node].childCount;
+        }
+        node = child;
+    }
+
+    return node;
+}
+
+bool LooseOctree::Fits(uint32_t node, XMFLOAT3 const & position, float radius) const
+{
+    Node const & n     = nodes_[node];
+    float        limit = 2.0f * n.halfSize - radius;
+    return radius <= n.halfSize &&
+           fabsf(position.x - n.center.x) <= limit &&
+           fabsf(position.y - n.center.y) <= limit &&
+           fabsf(position.z - n.center.z) <= limit;
+}
+
+void LooseOctree::Link(uint32_t id, uint32_t node)
+{
+    Object & o = objects_[id];
+    o.node     = node;
+    o.previous = NONE;
+    o.next     = nodes_[node].firstObject;
+    if (o.next != NONE)
+        objects_[o.next].previous = id;
+    nodes_[node].firstObject = id;
+}
+
+void LooseOctree::Unlink(uint32_t id)
+{
+    Object & o = objects_[id];
+    if (o.previous != NONE)
+        objects_[o.previous].next = o.next;
+    else
+        nodes_[o.node].firstObject = o.next;
+    if (o.next != NONE)
+        objects_[o.next].previous = o.previous;
+}
+
+void LooseOctree::Prune(uint32_t node)
+{
+    while (node != 0 && nodes_[node].firstObject == NONE && nodes_[node].childCount == 0)
+    {
+        uint32_t parent = nodes_[node].parent;
+        for (uint32_t & child : nodes_[parent].children)
+        {
+            if (child == node)
+                child = NONE;
+        }
+        --nodes_[parent].childCount;
+
+        nodes_[node].parent = freeNodes_;
+        freeNodes_          = node;
+        --nodeCount_;
+
+        node = parent;
+    }
+}
+
+uint32_t LooseOctree::AllocateNode(XMFLOAT3 const & center, float halfSize, uint32_t parent)
+{
+    uint32_t index;
+    if (freeNodes_ != NONE)
+    {
+        index      = freeNodes_;
+        freeNodes_ = nodes_[index].parent;
+    }
+    else
+    {
+        index = uint32_t(nodes_.size());
+        nodes_.emplace_back();
+    }
+
+    Node & node = nodes_[index];
+    node.center      = center;
+    node.halfSize    = halfSize;
+    node.parent      = parent;
+    node.childCount  = 0;
+    node.firstObject = NONE;
+    for (uint32_t & child : node.children)
+    {
+        child = NONE;
+    }
+
+    ++nodeCount_;
+    return index;
+}
+
+void LooseOctree::AppendSubtree(uint32_t node, std::vector<uint32_t> & visible) const
+{
+    Node const & n = nodes_[node];
+    for (uint32_t id = n.firstObject; id != NONE; id = objects_[id].next)
+    {
+        visible.push_back(id);
+    }
+    for (uint32_t child : n.children)
+    {
+        if (child != NONE)
+            AppendSubtree(child, visible);
+    }
+}
+} // namespace Dxx
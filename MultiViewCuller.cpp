@@ -0,0 +1,246 @@
+#include "MultiViewCuller.h"
+
+#include "Camera.h"
+#include "ParallelFor.h"
+#include "SimdLanes.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+size_t constexpr GRAIN  = 4096;     // Number of objects culled by a thread at a time (must be a multiple of 4)
+float constexpr EPSILON = 1.0e-5f;  // Planes whose components differ by less than this are considered the same
+
+// A plane with each component replicated across all 4 lanes, and the views that it bounds
+struct SplatPlane
+{
+    XMVECTOR a;
+    XMVECTOR b;
+    XMVECTOR c;
+    XMVECTOR d;
+    XMVECTOR absA;
+    XMVECTOR absB;
+    XMVECTOR absC;
+    uint32_t views;
+    uint32_t oppositeViews;
+};
+
+// 4 spheres
+struct SphereLanes
+{
+    SphereLanes(Dxx::SphereBounds const & spheres, size_t i)
+        : x(Dxx::Load4(spheres.x, i, spheres.count))
+        , y(Dxx::Load4(spheres.y, i, spheres.count))
+        , z(Dxx::Load4(spheres.z, i, spheres.count))
+        , r(Dxx::Load4(spheres.radius, i, spheres.count))
+    {
+    }
+
+    XMVECTOR distance(SplatPlane const & p) const
+    {
+        return XMVectorMultiplyAdd(p.a, x, XMVectorMultiplyAdd(p.b, y, XMVectorMultiplyAdd(p.c, z, p.d)));
+    }
+
+    XMVECTOR radius(SplatPlane const &) const { return r; }
+
+    XMVECTOR x;
+    XMVECTOR y;
+    XMVECTOR z;
+    XMVECTOR r;
+};
+
+// 4 boxes, as centers and half-extents
+struct BoxLanes
+{
+    BoxLanes(Dxx::BoxBounds const & boxes, size_t i)
+    {
+        XMVECTOR const half = XMVectorReplicate(0.5f);
+        XMVECTOR       minX = Dxx::Load4(boxes.minX, i, boxes.count);
+        XMVECTOR       minY = Dxx::Load4(boxes.minY, i, boxes.count);
+        XMVECTOR       minZ = Dxx::Load4(boxes.minZ, i, boxes.count);
+        XMVECTOR       maxX = Dxx::Load4(boxes.maxX, i, boxes.count);
+        XMVECTOR       maxY = Dxx::Load4(boxes.maxY, i, boxes.count);
+        XMVECTOR       maxZ = Dxx::Load4(boxes.maxZ, i, boxes.count);
+        cx = (minX + maxX) * half;
+        cy = (minY + maxY) * half;
+        cz = (minZ + maxZ) * half;
+        ex = (maxX - minX) * half;
+        ey = (maxY - minY) * half;
+        ez = (maxZ - minZ) * half;
+    }
+
+    XMVECTOR distance(SplatPlane const & p) const
+    {
+        return XMVectorMultiplyAdd(p.a, cx, XMVectorMultiplyAdd(p.b, cy, XMVectorMultiplyAdd(p.c, cz, p.d)));
+    }
+
+    XMVECTOR radius(SplatPlane const & p) const
+    {
+        return XMVectorMultiplyAdd(p.absA, ex, XMVectorMultiplyAdd(p.absB, ey, p.absC * ez));
+    }
+
+    XMVECTOR cx;
+    XMVECTOR cy;
+    XMVECTOR cz;
+    XMVECTOR ex;
+    XMVECTOR ey;
+    XMVECTOR ez;
+};
+
+// Computes the view masks of the objects in the range [begin, end). Each plane is tested once for all of the views
+// that it bounds, in either direction.
+template <typename Lanes, typename Bounds>
+void CullViews(std::vector<SplatPlane> const & planes, uint32_t allViews, Bounds const & bounds,
+               size_t begin, size_t end, uint8_t * pMasks)
+{
+    for (size_t i = begin; i < end; i += 4)
+    {
+        Lanes    lanes(bounds, i);
+        uint32_t culled[4] = { 0, 0, 0, 0 };
+
+        for (SplatPlane const & p : planes)
+        {
+            XMVECTOR distance = lanes.distance(p);
+            XMVECTOR radius   = lanes.radius(p);
+            uint32_t outside  = Dxx::LaneBits(XMVectorGreater(distance, radius));
+            uint32_t opposite = Dxx::LaneBits(XMVectorLess(distance, XMVectorNegate(radius)));
+            if ((outside | opposite) == 0)
+                continue;
+
+            for (int k = 0; k < 4; ++k)
+            {
+                if (outside & (1u << k))
+                    culled[k] |= p.views;
+                if (opposite & (1u << k))
+                    culled[k] |= p.oppositeViews;
+            }
+
+            if ((culled[0] & culled[1] & culled[2] & culled[3]) == allViews)
+                break;
+        }
+
+        size_t n = std::min<size_t>(end - i, 4);
+        for (size_t k = 0; k < n; ++k)
+        {
+            pMasks[i + k] = uint8_t(allViews & ~culled[k]);
+        }
+    }
+}
+
+// Replicates the planes. SharedPlane is MultiViewCuller::SharedPlane.
+template <typename SharedPlane>
+std::vector<SplatPlane> Splat(std::vector<SharedPlane> const & planes)
+{
+    std::vector<SplatPlane> splat(planes.size());
+    for (size_t i = 0; i < planes.size(); ++i)
+    {
+        XMFLOAT4 const & p = planes[i].plane;
+        splat[i].a             = XMVectorReplicate(p.x);
+        splat[i].b             = XMVectorReplicate(p.y);
+        splat[i].c             = XMVectorReplicate(p.z);
+        splat[i].d             = XMVectorReplicate(p.w);
+        splat[i].absA          = XMVectorReplicate(fabsf(p.x));
+        splat[i].absB          = XMVectorReplicate(fabsf(p.y));
+        splat[i].absC          = XMVectorReplicate(fabsf(p.z));
+        splat[i].views         = planes[i].views;
+        splat[i].oppositeViews = planes[i].oppositeViews;
+    }
+    return splat;
+}
+
+// Returns true if the planes are the same, within EPSILON. If sign is -1, returns true if they face opposite directions.
+bool SamePlane(XMFLOAT4 const & p, XMFLOAT4 const & q, float sign)
+{
+    return fabsf(p.x - sign * q.x) < EPSILON &&
+           fabsf(p.y - sign * q.y) < EPSILON &&
+           fabsf(p.z - sign * q.z) < EPSILON &&
+           fabsf(p.w - sign * q.w) < EPSILON * std::max(1.0f, fabsf(p.w));
+}
+} // anonymous namespace
+
+namespace Dxx
+{
+//! @param	frustum		The view's culling volume
+
+int MultiViewCuller::addView(CullingFrustum const & frustum)
+{
+    assert(viewCount_ < MAX_VIEWS);
+
+    int const     view = viewCount_++;
+    uint8_t const bit  = uint8_t(1u << view);
+
+    for (int i = 0; i < frustum.size(); ++i)
+    {
+        XMFLOAT4 const & p = frustum.plane(i);
+
+        auto same = std::find_if(planes_.begin(), planes_.end(), [&p] (SharedPlane const & s) {
+                                     return SamePlane(p, s.plane, 1.0f);
+                                 });
+        if (same != planes_.end())
+        {
+            same->views |= bit;
+            continue;
+        }
+
+        auto opposite = std::find_if(planes_.begin(), planes_.end(), [&p] (SharedPlane const & s) {
+                                         return SamePlane(p, s.plane, -1.0f);
+                                     });
+        if (opposite != planes_.end())
+        {
+            opposite->oppositeViews |= bit;
+            continue;
+        }
+
+        SharedPlane shared;
+        shared.plane         = p;
+        shared.views         = bit;
+        shared.oppositeViews = 0;
+        planes_.push_back(shared);
+    }
+
+    return view;
+}
+
+//! @param	camera	The camera
+
+int MultiViewCuller::addView(Camera const & camera)
+{
+    return addView(CullingFrustum(camera.viewProjectionMatrix()));
+}
+
+void MultiViewCuller::clear()
+{
+    planes_.clear();
+    viewCount_ = 0;
+}
+
+//! @param	spheres		Bounding spheres
+//! @param	pMasks		Where to store the masks. Bit @e v of mask @e i is set if sphere @e i is at least partially inside
+//!						view @e v. The array must have room for @a spheres.count masks.
+
+void MultiViewCuller::cullSpheres(SphereBounds const & spheres, uint8_t * pMasks) const
+{
+    std::vector<SplatPlane> splat    = Splat(planes_);
+    uint32_t const          allViews = (1u << viewCount_) - 1;
+    ParallelFor(spheres.count, GRAIN, [&] (size_t begin, size_t end) {
+                    CullViews<SphereLanes>(splat, allViews, spheres, begin, end, pMasks);
+                });
+}
+
+//! @param	boxes		Bounding boxes
+//! @param	pMasks		Where to store the masks. Bit @e v of mask @e i is set if box @e i is at least partially inside
+//!						view @e v. The array must have room for @a boxes.count masks.
+
+void MultiViewCuller::cullBoxes(BoxBounds const & boxes, uint8_t * pMasks) const
+{
+    std::vector<SplatPlane> splat    = Splat(planes_);
+    uint32_t const          allViews = (1u << viewCount_) - 1;
+    ParallelFor(boxes.count, GRAIN, [&] (size_t begin, size_t end) {
+                    CullViews<BoxLanes>(splat, allViews, boxes, begin, end, pMasks);
+                });
+}
+} // namespace Dxx
@@ -0,0 +1,200 @@
+#include "NormalConeClusters.h"
+
+#include "Camera.h"
+#include "Culling.h"
+#include "D3dx.h"
+#include "ParallelFor.h"
+#include "SimdLanes.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+size_t constexpr GRAIN = 4096;  // Number of clusters tested by a thread at a time (must be a multiple of 32)
+} // anonymous namespace
+
+namespace Dxx
+{
+//! Each cluster contains up to @a maxTriangles consecutive triangles. Degenerate triangles are ignored when computing
+//! the normal cones.
+//!
+//! @param	pVertices		Vertex positions
+//! @param	pIndexes		Triangle list indexes. The triangles are clockwise when viewed from the front.
+//! @param	indexCount		Number of indexes
+//! @param	maxTriangles	Maximum number of triangles in a cluster
+
+void NormalConeClusters::build(XMFLOAT3 const * pVertices,
+                               uint32_t const * pIndexes,
+                               size_t           indexCount,
+                               int              maxTriangles /*= 64*/)
+{
+    assert(maxTriangles > 0);
+
+    clusters_.clear();
+    x_.clear();
+    y_.clear();
+    z_.clear();
+    radius_.clear();
+    axisX_.clear();
+    axisY_.clear();
+    axisZ_.clear();
+    cosAngle_.clear();
+    sinAngle_.clear();
+
+    size_t const          clusterSize = size_t(maxTriangles) * 3;
+    std::vector<XMFLOAT3> normals;
+    normals.reserve(maxTriangles);
+
+    for (size_t first = 0; first + 3 <= indexCount; first += clusterSize)
+    {
+        size_t count = std::min(clusterSize, indexCount - first) / 3 * 3;
+
+        // Compute the face normals and the bounds
+
+        normals.clear();
+        XMVECTOR sum = XMVectorZero();
+        XMVECTOR lo  = XMVectorReplicate(FLT_MAX);
+        XMVECTOR hi  = XMVectorReplicate(-FLT_MAX);
+        for (size_t i = first; i < first + count; i += 3)
+        {
+            XMFLOAT3 const & v0 = pVertices[pIndexes[i]];
+            XMFLOAT3 const & v1 = pVertices[pIndexes[i + 1]];
+            XMFLOAT3 const & v2 = pVertices[pIndexes[i + 2]];
+            for (XMFLOAT3 const * v : { &v0, &v1, &v2 })
+            {
+                XMVECTOR p = XMLoadFloat3(v);
+                lo = XMVectorMin(lo, p);
+                hi = XMVectorMax(hi, p);
+            }
+
+            XMFLOAT3 n;
+            ComputeFaceNormal(v0, v1, v2, &n);
+            XMVECTOR n_simd = XMLoadFloat3(&n);
+            if (XMVectorGetX(XMVector3LengthSq(n_simd)) < 0.5f)
+                continue;   // The triangle is degenerate (the normal is 0)
+
+            sum += n_simd;
+            normals.push_back(n);
+        }
+
+        // The axis of the cone is the average normal, and the angle is the largest angle between it and any normal. If
+        // the angle is 90 degrees or more, the cluster can never be entirely back-facing, and the cone is set up so
+        // that the test always fails.
+
+        XMVECTOR center = (lo + hi) * XMVectorReplicate(0.5f);
+        XMVECTOR axis   = XMVectorZero();
+        float    minDot = -1.0f;
+        if (XMVectorGetX(XMVector3LengthSq(sum)) > FLT_EPSILON)
+        {
+            axis   = XMVector3Normalize(sum);
+            minDot = 1.0f;
+            for (XMFLOAT3 const & n : normals)
+            {
+                minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(axis, XMLoadFloat3(&n))));
+            }
+        }
+
+        float radius = 0.0f;
+        for (size_t i = first; i < first + count; ++i)
+        {
+            radius = std::max(radius, XMVectorGetX(XMVector3Length(XMLoadFloat3(&pVertices[pIndexes[i]]) - center)));
+        }
+
+        XMFLOAT3 c;
+        XMFLOAT3 a;
+        XMStoreFloat3(&c, center);
+        XMStoreFloat3(&a, axis);
+
+        Cluster cluster;
+        cluster.firstIndex = uint32_t(first);
+        cluster.indexCount = uint32_t(count);
+        clusters_.push_back(cluster);
+        x_.push_back(c.x);
+        y_.push_back(c.y);
+        z_.push_back(c.z);
+        radius_.push_back(radius);
+        axisX_.push_back(a.x);
+        axisY_.push_back(a.y);
+        axisZ_.push_back(a.z);
+        if (minDot > 0.0f)
+        {
+            cosAngle_.push_back(minDot);
+            sinAngle_.push_back(sqrtf(1.0f - minDot * minDot));
+        }
+        else
+        {
+            cosAngle_.push_back(0.0f);
+            sinAngle_.push_back(1.0f);
+        }
+    }
+}
+
+//! For a direction @e d from the eye to a point, the smallest dot product of @e d with any normal in the cone is
+//! <tt>dot(d, axis) * cos(angle) - |cross(d, axis)| * sin(angle)</tt>. This is evaluated at the center of the bounding
+//! sphere, and since it changes no faster than the distance from the center, the cluster is back-facing if it is
+//! greater than the radius.
+//!
+//! @param	eye			Position of the eye in the mesh's space
+//! @param	pVisible	Visibility bitset. The bits of back-facing clusters are cleared.
+
+void NormalConeClusters::cullBackfacing(XMFLOAT3 const & eye, uint32_t * pVisible) const
+{
+    size_t const   count = clusters_.size();
+    XMVECTOR const ex    = XMVectorReplicate(eye.x);
+    XMVECTOR const ey    = XMVectorReplicate(eye.y);
+    XMVECTOR const ez    = XMVectorReplicate(eye.z);
+
+    ParallelFor(count, GRAIN, [&] (size_t begin, size_t end) {
+                    for (size_t w = begin; w < end; w += 32)
+                    {
+                        size_t   n     = std::min<size_t>(end - w, 32);
+                        uint32_t front = 0;
+                        for (size_t j = 0; j < n; j += 4)
+                        {
+                            size_t   i  = w + j;
+                            XMVECTOR dx = Load4(x_.data(), i, count) - ex;
+                            XMVECTOR dy = Load4(y_.data(), i, count) - ey;
+                            XMVECTOR dz = Load4(z_.data(), i, count) - ez;
+                            XMVECTOR ax = Load4(axisX_.data(), i, count);
+                            XMVECTOR ay = Load4(axisY_.data(), i, count);
+                            XMVECTOR az = Load4(axisZ_.data(), i, count);
+
+                            XMVECTOR dot   = XMVectorMultiplyAdd(dx, ax, XMVectorMultiplyAdd(dy, ay, dz * az));
+                            XMVECTOR cx    = dy * az - dz * ay;
+                            XMVECTOR cy    = dz * ax - dx * az;
+                            XMVECTOR cz    = dx * ay - dy * ax;
+                            XMVECTOR cross = XMVectorSqrt(XMVectorMultiplyAdd(cx, cx, XMVectorMultiplyAdd(cy, cy, cz * cz)));
+                            XMVECTOR least = dot * Load4(cosAngle_.data(), i, count) -
+                                             cross * Load4(sinAngle_.data(), i, count);
+                            XMVECTOR back  = XMVectorGreater(least, Load4(radius_.data(), i, count));
+
+                            front |= (~LaneBits(back) & 0xfu) << j;
+                        }
+                        if (n < 32)
+                            front |= ~((1u << n) - 1);
+                        pVisible[w / 32] &= front;
+                    }
+                });
+}
+
+//! @param	camera		The camera
+//! @param	world		The mesh's world transformation
+//! @param	pVisible	Visibility bitset. The bits of back-facing clusters are cleared.
+
+void NormalConeClusters::cullBackfacing(Camera const & camera, XMFLOAT4X4 const & world, uint32_t * pVisible) const
+{
+    // Whether a triangle faces a point does not change when both are transformed (unless the transformation is a
+    // reflection), so the camera's position is transformed into the mesh's space instead of transforming the cones.
+
+    XMFLOAT3 position = camera.position();
+    XMMATRIX inverse  = XMMatrixInverse(nullptr, XMLoadFloat4x4(&world));
+    XMFLOAT3 eye;
+    XMStoreFloat3(&eye, XMVector3TransformCoord(XMLoadFloat3(&position), inverse));
+    cullBackfacing(eye, pVisible);
+}
+} // namespace Dxx
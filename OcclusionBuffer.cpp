@@ -0,0 +1,305 @@
+#include "OcclusionBuffer.h"
+
+#include "Camera.h"
+#include "ParallelFor.h"
+#include "ScreenBounds.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+size_t constexpr TEST_GRAIN = 1024; // Number of occludees tested by a thread at a time (must be a multiple of 32)
+
+// The coefficients of the edge function E(p) = a * p.x + b * p.y + c of the edge from (x0, y0) to (x1, y1). E(p) is
+// positive for points to the right of the edge (in screen space).
+struct Edge
+{
+    Edge(float x0, float y0, float x1, float y1)
+        : a(y0 - y1)
+        , b(x1 - x0)
+        , c(-(a * x0 + b * y0))
+    {
+    }
+
+    float a;
+    float b;
+    float c;
+};
+} // anonymous namespace
+
+namespace Dxx
+{
+//! @param	width	Width of the buffer in pixels (must be a multiple of 4)
+//! @param	height	Height of the buffer in pixels
+
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+    : width_(width)
+    , height_(height)
+    , tilesX_((width + TILE_WIDTH - 1) / TILE_WIDTH)
+    , tilesY_((height + TILE_HEIGHT - 1) / TILE_HEIGHT)
+    , depth_(size_t(width) * height, 1.0f)
+    , bins_(size_t(tilesX_) * tilesY_)
+{
+    assert(width > 0 && width % 4 == 0);
+    assert(height > 0);
+    XMStoreFloat4x4(&viewProjection_, XMMatrixIdentity());
+}
+
+//! @param	camera	The camera whose view-projection matrix is used to render the occluders
+
+void OcclusionBuffer::begin(Camera const & camera)
+{
+    begin(camera.viewProjectionMatrix());
+}
+
+//! @param	viewProjection	The view-projection matrix used to render the occluders
+
+void OcclusionBuffer::begin(XMFLOAT4X4 const & viewProjection)
+{
+    viewProjection_ = viewProjection;
+    std::fill(depth_.begin(), depth_.end(), 1.0f);
+    triangles_.clear();
+    for (auto & bin : bins_)
+    {
+        bin.clear();
+    }
+}
+
+//! The vertexes are transformed into screen space and the triangles are assigned to the tiles that they overlap.
+//! Nothing is drawn until rasterize() is called.
+//!
+//! @param	pVertices		Vertex positions
+//! @param	vertexCount		Number of vertexes
+//! @param	pIndexes		Triangle list indexes
+//! @param	indexCount		Number of indexes
+//! @param	world			World transformation of the mesh
+
+void OcclusionBuffer::addOccluder(XMFLOAT3 const *   pVertices,
+                                  size_t             vertexCount,
+                                  uint32_t const *   pIndexes,
+                                  size_t             indexCount,
+                                  XMFLOAT4X4 const & world)
+{
+    assert(indexCount % 3 == 0);
+
+    XMMATRIX m_simd = XMLoadFloat4x4(&world) * XMLoadFloat4x4(&viewProjection_);
+
+    clip_.resize(vertexCount);
+    XMVector3TransformStream(clip_.data(), sizeof(XMFLOAT4), pVertices, sizeof(XMFLOAT3), vertexCount, m_simd);
+
+    float const w = float(width_);
+    float const h = float(height_);
+
+    for (size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        XMFLOAT4 const * v[3] = { &clip_[pIndexes[i]], &clip_[pIndexes[i + 1]], &clip_[pIndexes[i + 2]] };
+
+        // Skip triangles with a vertex behind the eye (w <= 0) or in front of the near plane (z < 0). The GPU clips
+        // those parts of the occluder away, so rasterizing them could hide objects that are actually visible. Leaving
+        // out the whole triangle is conservative.
+        if (v[0]->w <= FLT_EPSILON || v[1]->w <= FLT_EPSILON || v[2]->w <= FLT_EPSILON)
+            continue;
+        if (v[0]->z < 0.0f || v[1]->z < 0.0f || v[2]->z < 0.0f)
+            continue;
+
+        Triangle t;
+        for (int k = 0; k < 3; ++k)
+        {
+            float invW = 1.0f / v[k]->w;
+            t.x[k] = (v[k]->x * invW * 0.5f + 0.5f) * w;
+            t.y[k] = (0.5f - v[k]->y * invW * 0.5f) * h;
+            t.z[k] = v[k]->z * invW;
+        }
+
+        // Skip degenerate triangles
+
+        float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.y[1] - t.y[0]) * (t.x[2] - t.x[0]);
+        if (fabsf(area) < FLT_EPSILON)
+            continue;
+
+        // Skip triangles that are off the screen
+
+        float minX = std::min({ t.x[0], t.x[1], t.x[2] });
+        float maxX = std::max({ t.x[0], t.x[1], t.x[2] });
+        float minY = std::min({ t.y[0], t.y[1], t.y[2] });
+        float maxY = std::max({ t.y[0], t.y[1], t.y[2] });
+        if (maxX < 0.0f || minX >= w || maxY < 0.0f || minY >= h)
+            continue;
+
+        // Add the triangle to the bins of the tiles that it overlaps
+
+        int tx0 = std::max(int(minX), 0) / TILE_WIDTH;
+        int tx1 = std::min(int(maxX), width_ - 1) / TILE_WIDTH;
+        int ty0 = std::max(int(minY), 0) / TILE_HEIGHT;
+        int ty1 = std::min(int(maxY), height_ - 1) / TILE_HEIGHT;
+
+        uint32_t index = uint32_t(triangles_.size());
+        triangles_.push_back(t);
+        for (int ty = ty0; ty <= ty1; ++ty)
+        {
+            for (int tx = tx0; tx <= tx1; ++tx)
+            {
+                bins_[ty * tilesX_ + tx].push_back(index);
+            }
+        }
+    }
+}
+
+void OcclusionBuffer::rasterize()
+{
+    ParallelFor(bins_.size(), 1, [this] (size_t begin, size_t end) {
+                    for (size_t tile = begin; tile < end; ++tile)
+                    {
+                        RasterizeTile(int(tile));
+                    }
+                });
+}
+
+//! @param	boxes		Bounds of the occludees
+//! @param	pVisible	Visibility bitset. On input, only the boxes whose bits are set are tested. On output, the bits
+//!						of the boxes that are completely occluded are cleared.
+
+void OcclusionBuffer::testBoxes(BoxBounds const & boxes, uint32_t * pVisible) const
+{
+    XMMATRIX viewProjection_simd = XMLoadFloat4x4(&viewProjection_);
+
+    ParallelFor(boxes.count, TEST_GRAIN, [&] (size_t begin, size_t end) {
+                    for (size_t w = begin / 32; w < VisibilityBitsetSize(end); ++w)
+                    {
+                        uint32_t bits = pVisible[w];
+                        for (uint32_t j = 0; j < 32; ++j)
+                        {
+                            size_t i = w * 32 + j;
+                            if (i >= end || !(bits & (1u << j)))
+                                continue;
+
+                            if (!IsVisible(viewProjection_simd,
+                                           XMFLOAT3(boxes.minX[i], boxes.minY[i], boxes.minZ[i]),
+                                           XMFLOAT3(boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i])))
+                            {
+                                bits &= ~(1u << j);
+                            }
+                        }
+                        pVisible[w] = bits;
+                    }
+                });
+}
+
+void OcclusionBuffer::RasterizeTile(int tile)
+{
+    int const tileX0 = (tile % tilesX_) * TILE_WIDTH;
+    int const tileY0 = (tile / tilesX_) * TILE_HEIGHT;
+    int const tileX1 = std::min(tileX0 + TILE_WIDTH, width_);
+    int const tileY1 = std::min(tileY0 + TILE_HEIGHT, height_);
+
+    XMVECTOR const pixelOffsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+
+    for (uint32_t index : bins_[tile])
+    {
+        Triangle t = triangles_[index];
+
+        // Make the triangle's winding consistent so that the edge functions are positive inside
+        float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.y[1] - t.y[0]) * (t.x[2] - t.x[0]);
+        if (area < 0.0f)
+        {
+            std::swap(t.x[1], t.x[2]);
+            std::swap(t.y[1], t.y[2]);
+            std::swap(t.z[1], t.z[2]);
+            area = -area;
+        }
+
+        Edge e0(t.x[1], t.y[1], t.x[2], t.y[2]);    // Opposite vertex 0
+        Edge e1(t.x[2], t.y[2], t.x[0], t.y[0]);    // Opposite vertex 1
+        Edge e2(t.x[0], t.y[0], t.x[1], t.y[1]);    // Opposite vertex 2
+
+        // Depth is interpolated using the barycentric coordinates, which are the edge functions divided by the area
+
+        float invArea = 1.0f / area;
+        float zA      = (e0.a * t.z[0] + e1.a * t.z[1] + e2.a * t.z[2]) * invArea;
+        float zB      = (e0.b * t.z[0] + e1.b * t.z[1] + e2.b * t.z[2]) * invArea;
+        float zC      = (e0.c * t.z[0] + e1.c * t.z[1] + e2.c * t.z[2]) * invArea;
+
+        // Bounds of the triangle within the tile. X is aligned to 4 pixels.
+
+        int x0 = std::max(int(floorf(std::min({ t.x[0], t.x[1], t.x[2] }))), tileX0) & ~3;
+        int x1 = std::min(int(ceilf(std::max({ t.x[0], t.x[1], t.x[2] }))), tileX1);
+        int y0 = std::max(int(floorf(std::min({ t.y[0], t.y[1], t.y[2] }))), tileY0);
+        int y1 = std::min(int(ceilf(std::max({ t.y[0], t.y[1], t.y[2] }))), tileY1);
+
+        XMVECTOR const a0 = XMVectorReplicate(e0.a);
+        XMVECTOR const a1 = XMVectorReplicate(e1.a);
+        XMVECTOR const a2 = XMVectorReplicate(e2.a);
+        XMVECTOR const za = XMVectorReplicate(zA);
+        XMVECTOR const zero = XMVectorZero();
+
+        for (int y = y0; y < y1; ++y)
+        {
+            float    py = float(y) + 0.5f;
+            XMVECTOR r0 = XMVectorReplicate(e0.b * py + e0.c);
+            XMVECTOR r1 = XMVectorReplicate(e1.b * py + e1.c);
+            XMVECTOR r2 = XMVectorReplicate(e2.b * py + e2.c);
+            XMVECTOR rz = XMVectorReplicate(zB * py + zC);
+            float *  pRow = &depth_[size_t(y) * width_];
+
+            for (int x = x0; x < x1; x += 4)
+            {
+                XMVECTOR px = XMVectorReplicate(float(x)) + pixelOffsets;
+
+                // Only pixels whose centers are strictly inside are covered
+                XMVECTOR inside = XMVectorAndInt(XMVectorAndInt(XMVectorGreater(XMVectorMultiplyAdd(a0, px, r0), zero),
+                                                                XMVectorGreater(XMVectorMultiplyAdd(a1, px, r1), zero)),
+                                                 XMVectorGreater(XMVectorMultiplyAdd(a2, px, r2), zero));
+                if (XMVector4EqualInt(inside, XMVectorFalseInt()))
+                    continue;
+
+                XMVECTOR z     = XMVectorMultiplyAdd(za, px, rz);
+                XMVECTOR depth = XMLoadFloat4(reinterpret_cast<XMFLOAT4 *>(pRow + x));
+                depth = XMVectorSelect(depth, XMVectorMin(depth, z), inside);
+                XMStoreFloat4(reinterpret_cast<XMFLOAT4 *>(pRow + x), depth);
+            }
+        }
+    }
+}
+
+bool OcclusionBuffer::IsVisible(FXMMATRIX viewProjection, XMFLOAT3 const & min, XMFLOAT3 const & max) const
+{
+    ScreenBounds bounds;
+    if (!ProjectBox(viewProjection, min, max, float(width_), float(height_), &bounds))
+        return true;    // The box crosses the near plane, so assume it is visible
+
+    int x0 = std::max(int(floorf(bounds.minX)), 0);
+    int x1 = std::min(int(floorf(bounds.maxX)) + 1, width_);
+    int y0 = std::max(int(floorf(bounds.minY)), 0);
+    int y1 = std::min(int(floorf(bounds.maxY)) + 1, height_);
+    if (x0 >= x1 || y0 >= y1)
+        return false;   // The box is off the screen
+
+    // The box is visible if its nearest depth is in front of the occluders at any pixel in its rectangle
+
+    XMVECTOR const minZ    = XMVectorReplicate(bounds.minZ);
+    XMVECTOR const first   = XMVectorReplicate(float(x0));
+    XMVECTOR const last    = XMVectorReplicate(float(x1));
+    XMVECTOR const offsets = XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f);
+
+    for (int y = y0; y < y1; ++y)
+    {
+        float const * pRow = &depth_[size_t(y) * width_];
+        for (int x = x0 & ~3; x < x1; x += 4)
+        {
+            XMVECTOR px      = XMVectorReplicate(float(x)) + offsets;
+            XMVECTOR inRange = XMVectorAndInt(XMVectorGreaterOrEqual(px, first), XMVectorLess(px, last));
+            XMVECTOR depth   = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(pRow + x));
+            XMVECTOR visible = XMVectorAndInt(XMVectorGreaterOrEqual(depth, minZ), inRange);
+            if (!XMVector4EqualInt(visible, XMVectorFalseInt()))
+                return true;
+        }
+    }
+
+    return false;
+}
+} // namespace Dxx
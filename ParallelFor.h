@@ -0,0 +1,188 @@
+#pragma once
+
+#if !defined(DXX_PARALLELFOR_H)
+#define DXX_PARALLELFOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Dxx
+{
+namespace ParallelForDetail
+{
+// Returns true if the calling thread is running a chunk of a ParallelFor
+inline bool & Nested()
+{
+    thread_local bool nested = false;
+    return nested;
+}
+
+// Calls a function object through a type-erased pointer
+template <typename Function>
+void Invoke(void * f)
+{
+    (*static_cast<Function *>(f))();
+}
+
+// A set of worker threads that are created once and woken for each ParallelFor. The threads sleep between jobs.
+class Pool
+{
+public:
+
+    // Returns the pool, creating it on first use
+    static Pool & instance()
+    {
+        static Pool pool;
+        return pool;
+    }
+
+    // Returns the number of threads that can run a job, including the calling thread
+    size_t size() const { return workers_.size() + 1; }
+
+    // Calls job(context) on the calling thread and on up to the given number of workers, and returns when all calls have
+    // returned. If another thread is already running a job, job(context) is only called on the calling thread.
+    void run(void (* job)(void *), void * context, size_t helpers)
+    {
+        std::unique_lock<std::mutex> busy(busy_, std::try_to_lock);
+        if (!busy.owns_lock())
+        {
+            job(context);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_      = job;
+            context_  = context;
+            wanted_   = std::min(helpers, workers_.size());
+            claimed_  = 0;
+            finished_ = 0;
+            ++generation_;
+        }
+        wake_.notify_all();
+
+        job(context);
+
+        // Workers that have not started yet are no longer needed, since the calling thread has finished all of the
+        // work that it could find. Wait only for the ones that have started.
+        std::unique_lock<std::mutex> lock(mutex_);
+        wanted_ = claimed_;
+        done_.wait(lock, [this] () { return finished_ == claimed_; });
+    }
+
+private:
+
+    Pool()
+    {
+        unsigned const count = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+        workers_.reserve(count);
+        for (unsigned i = 0; i < count; ++i)
+        {
+            workers_.emplace_back([this] () { Work(); });
+        }
+    }
+
+    ~Pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        wake_.notify_all();
+        for (auto & t : workers_)
+        {
+            t.join();
+        }
+    }
+
+    Pool(Pool const &) = delete;
+    Pool & operator =(Pool const &) = delete;
+
+    // Runs jobs until the pool is destroyed
+    void Work()
+    {
+        size_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            wake_.wait(lock, [&] () { return quit_ || generation_ != seen; });
+            if (quit_)
+                return;
+            seen = generation_;
+            if (claimed_ >= wanted_)
+                continue;
+
+            ++claimed_;
+            lock.unlock();
+            job_(context_);
+            lock.lock();
+            if (++finished_ == claimed_)
+                done_.notify_one();
+        }
+    }
+
+    std::mutex busy_;                       // Held by the thread running a job
+    std::mutex mutex_;                      // Guards the members below
+    std::condition_variable wake_;          // Signaled when a job is started or the pool is destroyed
+    std::condition_variable done_;          // Signaled when a worker finishes a job
+    std::vector<std::thread> workers_;      // The worker threads
+    void (* job_)(void *) = nullptr;        // The current job
+    void * context_ = nullptr;              // The current job's argument
+    size_t generation_ = 0;                 // Incremented for each job
+    size_t wanted_ = 0;                     // Number of workers that may run the current job
+    size_t claimed_ = 0;                    // Number of workers that have started the current job
+    size_t finished_ = 0;                   // Number of workers that have finished the current job
+    bool quit_ = false;                     // True if the workers should exit
+};
+} // namespace ParallelForDetail
+
+//! Calls f(begin, end) for consecutive subranges of [0, count) using all available hardware threads.
+//!
+//! The range is split into chunks of @a grain elements (the last chunk may be smaller), and the chunks are handed out
+//! to the threads as they become free. The boundaries of each chunk are multiples of @a grain, so if @a grain is a
+//! multiple of 32, then no two threads ever write to the same word of a bitset indexed by element. If there is only
+//! one chunk, or if ParallelFor is called from within another ParallelFor, @a f is called on the calling thread.
+//! The threads are created on first use and kept in a pool, so a call wakes them rather than creating them.
+//!
+//! @param	count	Number of elements
+//! @param	grain	Number of elements in each chunk
+//! @param	f		Function called for each chunk: void f(size_t begin, size_t end)
+
+template <typename Function>
+void ParallelFor(size_t count, size_t grain, Function f)
+{
+    if (count == 0)
+        return;
+
+    size_t const chunks  = (count + grain - 1) / grain;
+    size_t const threads = std::min(ParallelForDetail::Pool::instance().size(), chunks);
+
+    if (threads <= 1 || ParallelForDetail::Nested())
+    {
+        f(size_t(0), count);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    auto worker = [&] ()
+                  {
+                      bool & nested = ParallelForDetail::Nested();
+                      bool   outer  = nested;
+                      nested = true;
+                      for (size_t c = next++; c < chunks; c = next++)
+                      {
+                          size_t const begin = c * grain;
+                          f(begin, std::min(begin + grain, count));
+                      }
+                      nested = outer;
+                  };
+
+    ParallelForDetail::Pool::instance().run(&ParallelForDetail::Invoke<decltype(worker)>, &worker, threads - 1);
+}
+} // namespace Dxx
+
+#endif // !defined(DXX_PARALLELFOR_H)
@@ -0,0 +1,212 @@
+#include "PortalGraph.h"
+
+#include "Camera.h"
+
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+int constexpr MAX_CLIPPED_VERTICES = Dxx::PortalGraph::MAX_PORTAL_VERTICES + Dxx::CullingFrustum::MAX_PLANES;
+int constexpr FAR_PLANE            = 5;         // Index of the far plane in a CullingFrustum made from a camera
+float constexpr EPSILON            = 1.0e-5f;   // Distances and squared lengths smaller than this are treated as 0
+
+// Clips a convex polygon to the inside of a plane and returns the number of vertexes in the result
+int ClipPolygon(XMVECTOR const * pIn, int count, FXMVECTOR plane, XMVECTOR * pOut)
+{
+    int n = 0;
+    XMVECTOR s  = pIn[count - 1];
+    float    ds = XMVectorGetX(XMPlaneDotCoord(plane, s));
+    for (int i = 0; i < count; ++i)
+    {
+        XMVECTOR e  = pIn[i];
+        float    de = XMVectorGetX(XMPlaneDotCoord(plane, e));
+        if ((ds > 0.0f) != (de > 0.0f))
+            pOut[n++] = XMVectorLerp(s, e, ds / (ds - de));
+        if (de <= 0.0f)
+            pOut[n++] = e;
+        s  = e;
+        ds = de;
+    }
+    return n;
+}
+} // anonymous namespace
+
+namespace Dxx
+{
+int PortalGraph::addCell()
+{
+    cells_.emplace_back();
+    return int(cells_.size()) - 1;
+}
+
+//! @param	cellA,cellB		The cells on either side of the portal
+//! @param	pVertices		The vertexes of the portal. The portal must be convex and planar, and the vertexes must be in
+//!							order around its edge (in either direction).
+//! @param	vertexCount		Number of vertexes (at least 3, at most MAX_PORTAL_VERTICES)
+
+int PortalGraph::addPortal(int cellA, int cellB, XMFLOAT3 const * pVertices, int vertexCount)
+{
+    assert(cellA >= 0 && cellA < int(cells_.size()));
+    assert(cellB >= 0 && cellB < int(cells_.size()));
+    assert(vertexCount >= 3 && vertexCount <= MAX_PORTAL_VERTICES);
+
+    // Compute the plane of the portal using Newell's method, which is robust for nearly collinear vertexes
+
+    XMVECTOR normal   = XMVectorZero();
+    XMVECTOR centroid = XMVectorZero();
+    for (int i = 0; i < vertexCount; ++i)
+    {
+        XMFLOAT3 const & a = pVertices[i];
+        XMFLOAT3 const & b = pVertices[(i + 1) % vertexCount];
+        normal   += XMVectorSet((a.y - b.y) * (a.z + b.z), (a.z - b.z) * (a.x + b.x), (a.x - b.x) * (a.y + b.y), 0.0f);
+        centroid += XMLoadFloat3(&a);
+    }
+    centroid /= XMVectorReplicate(float(vertexCount));
+
+    Portal portal;
+    portal.cells[0]    = cellA;
+    portal.cells[1]    = cellB;
+    portal.firstVertex = uint32_t(vertices_.size());
+    portal.vertexCount = vertexCount;
+    XMStoreFloat4(&portal.plane, XMPlaneNormalize(XMPlaneFromPointNormal(centroid, normal)));
+
+    vertices_.insert(vertices_.end(), pVertices, pVertices + vertexCount);
+    portals_.push_back(portal);
+
+    int index = int(portals_.size()) - 1;
+    cells_[cellA].push_back(index);
+    cells_[cellB].push_back(index);
+    return index;
+}
+
+//! The cell containing the camera is always visible and is reported first with the camera's view frustum. A cell may
+//! be reported more than once if it can be seen through more than one sequence of portals.
+//!
+//! @param	camera		The camera
+//! @param	cell		Index of the cell containing the camera
+//! @param	visible		The visible cells are appended to this list
+
+void PortalGraph::findVisibleCells(Camera const & camera, int cell, std::vector<VisibleCell> & visible) const
+{
+    assert(cell >= 0 && cell < int(cells_.size()));
+
+    CullingFrustum       frustum(camera.viewProjectionMatrix());
+    std::vector<uint8_t> onPath(cells_.size(), 0);
+    Visit(cell, frustum, camera.position(), frustum.plane(FAR_PLANE), onPath, visible);
+}
+
+void PortalGraph::Visit(int                        cell,
+                        CullingFrustum const &     frustum,
+                        XMFLOAT3 const &           eye,
+                        XMFLOAT4 const &           farPlane,
+                        std::vector<uint8_t> &     onPath,
+                        std::vector<VisibleCell> & visible) const
+{
+    VisibleCell v;
+    v.cell    = cell;
+    v.frustum = frustum;
+    visible.push_back(v);
+
+    // A cell is not visited again through its own portals, which would make a loop
+
+    onPath[cell] = 1;
+    for (int p : cells_[cell])
+    {
+        Portal const & portal = portals_[p];
+        int            next   = (portal.cells[0] == cell) ? portal.cells[1] : portal.cells[0];
+        if (onPath[next])
+            continue;
+
+        CullingFrustum narrowed;
+        if (Narrow(portal, frustum, eye, farPlane, &narrowed))
+            Visit(next, narrowed, eye, farPlane, onPath, visible);
+    }
+    onPath[cell] = 0;
+}
+
+//! The portal is clipped to the frustum, and the narrowed frustum is bounded by the planes through the eye and each
+//! edge of the clipped portal, the plane of the portal, and the far plane. If the frustum cannot be narrowed safely
+//! (for example, because the eye is in the plane of the portal), the original frustum is used.
+
+bool PortalGraph::Narrow(Portal const &         portal,
+                         CullingFrustum const & frustum,
+                         XMFLOAT3 const &       eye,
+                         XMFLOAT4 const &       farPlane,
+                         CullingFrustum *       pNarrowed) const
+{
+    // Clip the portal to the frustum
+
+    XMVECTOR buffers[2][MAX_CLIPPED_VERTICES];
+    int      count = portal.vertexCount;
+    for (int i = 0; i < count; ++i)
+    {
+        buffers[0][i] = XMLoadFloat3(&vertices_[portal.firstVertex + i]);
+    }
+
+    int in = 0;
+    for (int i = 0; i < frustum.size() && count >= 3; ++i)
+    {
+        count = ClipPolygon(buffers[in], count, XMLoadFloat4(&frustum.plane(i)), buffers[1 - in]);
+        in    = 1 - in;
+    }
+    if (count < 3)
+        return false;
+
+    XMVECTOR const * pClipped = buffers[in];
+
+    // The eye must be on the outside of the portal's plane. If it is in the plane or there are too many edges, the
+    // frustum is not narrowed.
+
+    XMVECTOR eye_simd = XMLoadFloat3(&eye);
+    XMVECTOR plane    = XMLoadFloat4(&portal.plane);
+    float    eyeSide  = XMVectorGetX(XMPlaneDotCoord(plane, eye_simd));
+    if (fabsf(eyeSide) < EPSILON || count > CullingFrustum::MAX_PLANES - 2)
+    {
+        *pNarrowed = frustum;
+        return true;
+    }
+
+    XMVECTOR centroid = XMVectorZero();
+    for (int i = 0; i < count; ++i)
+    {
+        centroid += pClipped[i];
+    }
+    centroid /= XMVectorReplicate(float(count));
+
+    // Add the planes through the eye and each edge, oriented so that the centroid of the portal is inside
+
+    CullingFrustum narrowed;
+    for (int i = 0; i < count; ++i)
+    {
+        XMVECTOR a      = pClipped[i] - eye_simd;
+        XMVECTOR b      = pClipped[(i + 1) % count] - eye_simd;
+        XMVECTOR normal = XMVector3Cross(a, b);
+        if (XMVectorGetX(XMVector3LengthSq(normal)) < EPSILON * EPSILON)
+            continue;   // Skipping a degenerate edge only makes the frustum larger
+
+        XMVECTOR edgePlane = XMPlaneFromPointNormal(eye_simd, normal);
+        if (XMVectorGetX(XMPlaneDotCoord(edgePlane, centroid)) > 0.0f)
+            edgePlane = XMVectorNegate(edgePlane);
+
+        XMFLOAT4 p;
+        XMStoreFloat4(&p, edgePlane);
+        narrowed.add(p);
+    }
+
+    // Add the plane of the portal, oriented so that the eye is outside, and the far plane
+
+    if (eyeSide < 0.0f)
+        plane = XMVectorNegate(plane);
+
+    XMFLOAT4 p;
+    XMStoreFloat4(&p, plane);
+    narrowed.add(p);
+    narrowed.add(farPlane);
+
+    *pNarrowed = narrowed;
+    return true;
+}
+} // namespace Dxx
@@ -0,0 +1,232 @@
+#include "PotentiallyVisibleSet.h"
+
+#include "Camera.h"
+#include "OcclusionBuffer.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+// Encoded bitset tokens. The high 2 bits are the type and the low 30 bits are the number of words.
+uint32_t constexpr ZEROS      = 0u << 30;   // A run of words that are all 0
+uint32_t constexpr ONES       = 1u << 30;   // A run of words that are all 1
+uint32_t constexpr LITERALS   = 2u << 30;   // Words that are stored as is (they follow the token)
+uint32_t constexpr TYPE_MASK  = 3u << 30;
+uint32_t constexpr COUNT_MASK = ~TYPE_MASK;
+
+float constexpr HALF_SQRT2 = 0.70710678f;
+
+// Orientations of the sample cameras. Together, the views cover all directions.
+XMFLOAT4 const VIEW_ORIENTATIONS[] =
+{
+    {  0.0f,       0.0f,        0.0f, 1.0f       },    // +Z
+    {  0.0f,       1.0f,        0.0f, 0.0f       },    // -Z
+    {  0.0f,       HALF_SQRT2,  0.0f, HALF_SQRT2 },    // +X
+    {  0.0f,       -HALF_SQRT2, 0.0f, HALF_SQRT2 },    // -X
+    {  HALF_SQRT2, 0.0f,        0.0f, HALF_SQRT2 },    // -Y
+    { -HALF_SQRT2, 0.0f,        0.0f, HALF_SQRT2 }     // +Y
+};
+
+float constexpr VIEW_ANGLE = 90.0f; // Angle of view of the sample cameras (in degrees)
+
+// Appends the run-length encoding of a bitset
+void Encode(uint32_t const * pBits, size_t size, std::vector<uint32_t> & out)
+{
+    size_t i = 0;
+    while (i < size)
+    {
+        uint32_t w = pBits[i];
+        size_t   j = i + 1;
+        if (w == 0 || w == ~0u)
+        {
+            while (j < size && pBits[j] == w && j - i < COUNT_MASK)
+            {
+                ++j;
+            }
+            out.push_back(((w == 0) ? ZEROS : ONES) | uint32_t(j - i));
+        }
+        else
+        {
+            while (j < size && pBits[j] != 0 && pBits[j] != ~0u && j - i < COUNT_MASK)
+            {
+                ++j;
+            }
+            out.push_back(LITERALS | uint32_t(j - i));
+            out.insert(out.end(), pBits + i, pBits + j);
+        }
+        i = j;
+    }
+}
+} // anonymous namespace
+
+namespace Dxx
+{
+//! The cells are baked in parallel.
+//!
+//! @param	grid			The view cells
+//! @param	objects			Bounds of the static objects
+//! @param	pOccluders		Occluder meshes
+//! @param	occluderCount	Number of occluders
+//! @param	settings		Baking parameters
+
+void PotentiallyVisibleSet::bake(Grid const &         grid,
+                                 BoxBounds const &    objects,
+                                 Occluder const *     pOccluders,
+                                 size_t               occluderCount,
+                                 BakeSettings const & settings)
+{
+    assert(grid.cellsX > 0 && grid.cellsY > 0 && grid.cellsZ > 0);
+    assert(settings.samplesPerAxis > 0);
+
+    grid_        = grid;
+    objectCount_ = objects.count;
+
+    int const    cells = cellCount();
+    size_t const words = VisibilityBitsetSize(objects.count);
+    int const    n     = settings.samplesPerAxis;
+
+    // Each cell is encoded separately and then they are concatenated
+
+    std::vector<std::vector<uint32_t> > encoded(cells);
+
+    ParallelFor(cells, 1, [&] (size_t begin, size_t end) {
+                    OcclusionBuffer       buffer(settings.resolution, settings.resolution);
+                    std::vector<uint32_t> cellBits(words);
+                    std::vector<uint32_t> viewBits(words);
+
+                    for (size_t cell = begin; cell < end; ++cell)
+                    {
+                        int ix = int(cell % grid.cellsX);
+                        int iy = int(cell / grid.cellsX % grid.cellsY);
+                        int iz = int(cell / grid.cellsX / grid.cellsY);
+
+                        std::fill(cellBits.begin(), cellBits.end(), 0);
+
+                        // The sample positions are at the centers of an n x n x n subdivision of the cell
+                        for (int s = 0; s < n * n * n; ++s)
+                        {
+                            XMFLOAT3 position(grid.origin.x + (ix + (s % n + 0.5f) / n) * grid.cellSize.x,
+                                              grid.origin.y + (iy + (s / n % n + 0.5f) / n) * grid.cellSize.y,
+                                              grid.origin.z + (iz + (s / n / n + 0.5f) / n) * grid.cellSize.z);
+
+                            for (XMFLOAT4 const & orientation : VIEW_ORIENTATIONS)
+                            {
+                                Camera camera(VIEW_ANGLE, settings.nearDistance, settings.farDistance, 1.0f, position,
+                                              orientation);
+
+                                CullBoxes(CullingFrustum(camera.viewProjectionMatrix()), objects, viewBits.data());
+
+                                buffer.begin(camera);
+                                for (size_t i = 0; i < occluderCount; ++i)
+                                {
+                                    Occluder const & o = pOccluders[i];
+                                    buffer.addOccluder(o.pVertices, o.vertexCount, o.pIndexes, o.indexCount, o.world);
+                                }
+                                buffer.rasterize();
+                                buffer.testBoxes(objects, viewBits.data());
+
+                                for (size_t w = 0; w < words; ++w)
+                                {
+                                    cellBits[w] |= viewBits[w];
+                                }
+                            }
+                        }
+
+                        Encode(cellBits.data(), words, encoded[cell]);
+                    }
+                });
+
+    offsets_.resize(cells + 1);
+    data_.clear();
+    for (int i = 0; i < cells; ++i)
+    {
+        offsets_[i] = uint32_t(data_.size());
+        data_.insert(data_.end(), encoded[i].begin(), encoded[i].end());
+    }
+    offsets_[cells] = uint32_t(data_.size());
+}
+
+//! @param	position	A position
+
+int PotentiallyVisibleSet::findCell(XMFLOAT3 const & position) const
+{
+    int ix = int(floorf((position.x - grid_.origin.x) / grid_.cellSize.x));
+    int iy = int(floorf((position.y - grid_.origin.y) / grid_.cellSize.y));
+    int iz = int(floorf((position.z - grid_.origin.z) / grid_.cellSize.z));
+    if (ix < 0 || ix >= grid_.cellsX || iy < 0 || iy >= grid_.cellsY || iz < 0 || iz >= grid_.cellsZ)
+        return -1;
+
+    return (iz * grid_.cellsY + iy) * grid_.cellsX + ix;
+}
+
+//! @param	cell		Index of the cell
+//! @param	pVisible	Where to store the visibility bitset. It must have room for VisibilityBitsetSize(objectCount())
+//!						words.
+
+void PotentiallyVisibleSet::getVisible(int cell, uint32_t * pVisible) const
+{
+    assert(cell >= 0 && cell < cellCount());
+
+    uint32_t const * p   = data_.data() + offsets_[cell];
+    uint32_t const * end = data_.data() + offsets_[cell + 1];
+    while (p < end)
+    {
+        uint32_t token = *p++;
+        uint32_t count = token & COUNT_MASK;
+        switch (token & TYPE_MASK)
+        {
+            case ZEROS:
+                std::fill(pVisible, pVisible + count, 0u);
+                break;
+            case ONES:
+                std::fill(pVisible, pVisible + count, ~0u);
+                break;
+            default:
+                std::copy(p, p + count, pVisible);
+                p += count;
+                break;
+        }
+        pVisible += count;
+    }
+}
+
+//! This is typically used to remove the objects that cannot be seen from the camera's position from the results of
+//! frustum culling.
+//!
+//! @param	cell		Index of the cell
+//! @param	pVisible	Visibility bitset
+
+void PotentiallyVisibleSet::filterVisible(int cell, uint32_t * pVisible) const
+{
+    assert(cell >= 0 && cell < cellCount());
+
+    uint32_t const * p   = data_.data() + offsets_[cell];
+    uint32_t const * end = data_.data() + offsets_[cell + 1];
+    while (p < end)
+    {
+        uint32_t token = *p++;
+        uint32_t count = token & COUNT_MASK;
+        switch (token & TYPE_MASK)
+        {
+            case ZEROS:
+                std::fill(pVisible, pVisible + count, 0u);
+                break;
+            case ONES:
+                break;
+            default:
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    pVisible[i] &= p[i];
+                }
+                p += count;
+                break;
+        }
+        pVisible += count;
+    }
+}
+} // namespace Dxx
@@ -0,0 +1,159 @@
+#include "PrimaryRays.h"
+
+#include "Camera.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+size_t constexpr GRAIN = 4096;  // Number of rays generated by a thread at a time (must be a multiple of 4)
+
+// Stores the first n lanes of a vector
+void Store4(FXMVECTOR v, size_t n, float * p)
+{
+    XMFLOAT4 values;
+    XMStoreFloat4(&values, v);
+    std::copy(&values.x, &values.x + n, p);
+}
+} // anonymous namespace
+
+namespace Dxx
+{
+//! The rays are in tile order: the rectangle is divided into tiles of @a tileSize x @a tileSize pixels, the tiles are
+//! in rows from the top left, and the pixels in each tile are in rows from the top left. Neighboring rays are therefore
+//! close together in both directions, which keeps packets of rays coherent.
+//!
+//! The rays are computed from the camera's frame of reference, angle of view, aspect ratio, and view offset, so
+//! they match the camera's projection matrix (without the camera's jitter). The camera must not be scaled.
+//!
+//! @param	camera			The camera
+//! @param	viewportWidth	Width of the viewport in pixels
+//! @param	viewportHeight	Height of the viewport in pixels
+//! @param	x				Left edge of the rectangle in pixels
+//! @param	y				Top edge of the rectangle in pixels
+//! @param	width			Width of the rectangle in pixels
+//! @param	height			Height of the rectangle in pixels
+//! @param	pJitter			Offset of ray @e i from the center of its pixel, in pixels, or nullptr to pass each ray
+//!							through the center of its pixel. The offsets are indexed in tile order.
+//! @param	rays			Where to store the rays. Its contents are replaced.
+//! @param	tileSize		Width and height of a tile in pixels
+
+void GeneratePrimaryRays(Camera const &   camera,
+                         int              viewportWidth,
+                         int              viewportHeight,
+                         int              x,
+                         int              y,
+                         int              width,
+                         int              height,
+                         XMFLOAT2 const * pJitter,
+                         PrimaryRays &    rays,
+                         int              tileSize /*= 8*/)
+{
+    assert(viewportWidth > 0 && viewportHeight > 0);
+    assert(width >= 0 && height >= 0);
+    assert(tileSize > 0);
+
+    size_t const count = size_t(width) * size_t(height);
+    for (auto * v : { &rays.originX, &rays.originY, &rays.originZ,
+                      &rays.directionX, &rays.directionY, &rays.directionZ })
+    {
+        v->resize(count);
+    }
+    rays.pixelX.resize(count);
+    rays.pixelY.resize(count);
+
+    // List the pixels in tile order
+
+    size_t i = 0;
+    for (int ty = 0; ty < height; ty += tileSize)
+    {
+        for (int tx = 0; tx < width; tx += tileSize)
+        {
+            int const bottom = std::min(ty + tileSize, height);
+            int const right  = std::min(tx + tileSize, width);
+            for (int py = ty; py < bottom; ++py)
+            {
+                for (int px = tx; px < right; ++px)
+                {
+                    rays.pixelX[i] = uint32_t(x + px);
+                    rays.pixelY[i] = uint32_t(y + py);
+                    ++i;
+                }
+            }
+        }
+    }
+
+    // The near plane's window in view space is [offset.x - w, offset.x + w] x [offset.y - h, offset.y + h]. A pixel's
+    // point on the window is (a + b * sx, c + d * sy, near), where (sx, sy) is the position in pixels.
+
+    float const    nearDistance = camera.nearDistance();
+    float const    h            = tanf(camera.angleOfView() * 0.5f) * nearDistance;
+    float const    w            = h * camera.aspectRatio();
+    XMFLOAT2 const offset       = camera.viewOffset();
+
+    XMVECTOR const a = XMVectorReplicate(offset.x - w);
+    XMVECTOR const b = XMVectorReplicate(2.0f * w / float(viewportWidth));
+    XMVECTOR const c = XMVectorReplicate(offset.y + h);
+    XMVECTOR const d = XMVectorReplicate(-2.0f * h / float(viewportHeight));
+
+    // The rows of the frame's transformation are the camera's axes and position in world space
+
+    XMFLOAT4X4 const frame = camera.frame().transformation();
+    XMVECTOR const   rx    = XMVectorReplicate(frame._11);
+    XMVECTOR const   ry    = XMVectorReplicate(frame._12);
+    XMVECTOR const   rz    = XMVectorReplicate(frame._13);
+    XMVECTOR const   ux    = XMVectorReplicate(frame._21);
+    XMVECTOR const   uy    = XMVectorReplicate(frame._22);
+    XMVECTOR const   uz    = XMVectorReplicate(frame._23);
+    XMVECTOR const   fx    = XMVectorReplicate(frame._31 * nearDistance);
+    XMVECTOR const   fy    = XMVectorReplicate(frame._32 * nearDistance);
+    XMVECTOR const   fz    = XMVectorReplicate(frame._33 * nearDistance);
+    XMVECTOR const   ex    = XMVectorReplicate(frame._41);
+    XMVECTOR const   ey    = XMVectorReplicate(frame._42);
+    XMVECTOR const   ez    = XMVectorReplicate(frame._43);
+
+    ParallelFor(count, GRAIN, [&] (size_t begin, size_t end) {
+                    for (size_t j = begin; j < end; j += 4)
+                    {
+                        size_t const n = std::min<size_t>(end - j, 4);
+
+                        XMFLOAT4 sx(0.0f, 0.0f, 0.0f, 0.0f);
+                        XMFLOAT4 sy(0.0f, 0.0f, 0.0f, 0.0f);
+                        float *  px = &sx.x;
+                        float *  py = &sy.x;
+                        for (size_t k = 0; k < n; ++k)
+                        {
+                            px[k] = float(rays.pixelX[j + k]) + 0.5f;
+                            py[k] = float(rays.pixelY[j + k]) + 0.5f;
+                            if (pJitter)
+                            {
+                                px[k] += pJitter[j + k].x;
+                                py[k] += pJitter[j + k].y;
+                            }
+                        }
+
+                        // The vector from the eye to the point on the near plane, in world space
+                        XMVECTOR vx = XMVectorMultiplyAdd(XMLoadFloat4(&sx), b, a);
+                        XMVECTOR vy = XMVectorMultiplyAdd(XMLoadFloat4(&sy), d, c);
+                        XMVECTOR dx = XMVectorMultiplyAdd(vx, rx, XMVectorMultiplyAdd(vy, ux, fx));
+                        XMVECTOR dy = XMVectorMultiplyAdd(vx, ry, XMVectorMultiplyAdd(vy, uy, fy));
+                        XMVECTOR dz = XMVectorMultiplyAdd(vx, rz, XMVectorMultiplyAdd(vy, uz, fz));
+
+                        Store4(ex + dx, n, &rays.originX[j]);
+                        Store4(ey + dy, n, &rays.originY[j]);
+                        Store4(ez + dz, n, &rays.originZ[j]);
+
+                        XMVECTOR length2 = XMVectorMultiplyAdd(dx, dx, XMVectorMultiplyAdd(dy, dy, dz * dz));
+                        XMVECTOR s       = XMVectorReciprocalSqrt(length2);
+                        Store4(dx * s, n, &rays.directionX[j]);
+                        Store4(dy * s, n, &rays.directionY[j]);
+                        Store4(dz * s, n, &rays.directionZ[j]);
+                    }
+                });
+}
+} // namespace Dxx
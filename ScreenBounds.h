@@ -0,0 +1,65 @@
+#pragma once
+
+#if !defined(DXX_SCREENBOUNDS_H)
+#define DXX_SCREENBOUNDS_H
+
+#include <algorithm>
+#include <cfloat>
+#include <DirectXMath.h>
+
+namespace Dxx
+{
+//! The screen-space bounds of a projected box.
+struct ScreenBounds
+{
+    float minX;     //!< Left edge (in pixels)
+    float minY;     //!< Top edge (in pixels)
+    float maxX;     //!< Right edge (in pixels)
+    float maxY;     //!< Bottom edge (in pixels)
+    float minZ;     //!< Nearest depth (z / w)
+};
+
+//! Projects an axis-aligned box onto the screen.
+//!
+//! @param	viewProjection	View-projection matrix
+//! @param	min,max			Corners of the box
+//! @param	width,height	Size of the screen in pixels
+//! @param	pBounds			Where to store the bounds
+//!
+//! @return		false if any part of the box is behind the near plane, in which case the bounds are not valid
+
+inline bool ProjectBox(DirectX::FXMMATRIX        viewProjection,
+                       DirectX::XMFLOAT3 const & min,
+                       DirectX::XMFLOAT3 const & max,
+                       float                     width,
+                       float                     height,
+                       ScreenBounds *            pBounds)
+{
+    using namespace DirectX;
+
+    XMVECTOR lo = XMVectorReplicate(FLT_MAX);
+    XMVECTOR hi = XMVectorReplicate(-FLT_MAX);
+    for (int i = 0; i < 8; ++i)
+    {
+        XMVECTOR corner = XMVectorSet((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z, 1.0f);
+        XMVECTOR clip   = XMVector4Transform(corner, viewProjection);
+        float    w      = XMVectorGetW(clip);
+        if (w <= FLT_EPSILON)
+            return false;
+
+        XMVECTOR ndc = clip / XMVectorReplicate(w);
+        lo = XMVectorMin(lo, ndc);
+        hi = XMVectorMax(hi, ndc);
+    }
+
+    // Note that Y is flipped when converting to screen space
+    pBounds->minX = (XMVectorGetX(lo) * 0.5f + 0.5f) * width;
+    pBounds->maxX = (XMVectorGetX(hi) * 0.5f + 0.5f) * width;
+    pBounds->minY = (0.5f - XMVectorGetY(hi) * 0.5f) * height;
+    pBounds->maxY = (0.5f - XMVectorGetY(lo) * 0.5f) * height;
+    pBounds->minZ = std::max(XMVectorGetZ(lo), 0.0f);
+    return true;
+}
+} // namespace Dxx
+
+#endif // !defined(DXX_SCREENBOUNDS_H)
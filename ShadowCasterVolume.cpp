@@ -0,0 +1,129 @@
+#include "ShadowCasterVolume.h"
+
+#include "Camera.h"
+#include "Light.h"
+
+#include <cfloat>
+
+using namespace DirectX;
+
+namespace
+{
+// The index of the plane (in a CullingFrustum made from a view-projection matrix) that contains the corners with the
+// given value of the given bit of the corner index. The bits of a corner index are x, y, and z (0 = minimum).
+int const FACES[3][2] =
+{
+    { 0, 1 },   // Left, right
+    { 3, 2 },   // Bottom, top
+    { 4, 5 }    // Front, back
+};
+
+// Builds the volume swept by a view frustum toward a light. The light is given in homogeneous form: the direction
+// toward the light with w = 0, or the position of the light with w = 1.
+Dxx::CullingFrustum SweptVolume(XMFLOAT4X4 const & viewProjection, FXMVECTOR light)
+{
+    Dxx::CullingFrustum frustum(viewProjection);
+
+    // Compute the corners by transforming the corners of the clip volume back into world space
+
+    XMMATRIX inverse = XMMatrixInverse(nullptr, XMLoadFloat4x4(&viewProjection));
+    XMVECTOR corners[8];
+    XMVECTOR center = XMVectorZero();
+    for (int i = 0; i < 8; ++i)
+    {
+        XMVECTOR ndc = XMVectorSet((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : 0.0f, 1.0f);
+        corners[i] = XMVector3TransformCoord(ndc, inverse);
+        center    += corners[i];
+    }
+    center *= XMVectorReplicate(0.125f);
+
+    // A plane faces the light if the light is outside of it. The planes that face away from the light are part of the
+    // volume.
+
+    bool facing[6];
+    Dxx::CullingFrustum volume;
+    for (int i = 0; i < 6; ++i)
+    {
+        XMVECTOR plane = XMLoadFloat4(&frustum.plane(i));
+        facing[i] = XMVectorGetX(XMPlaneDot(plane, light)) > 0.0f;
+        if (!facing[i])
+            volume.add(frustum.plane(i));
+    }
+
+    // An edge between a plane that faces the light and one that does not is on the silhouette. The plane through the
+    // edge and the light is part of the volume.
+
+    float const lightW = XMVectorGetW(light);
+    for (int i = 0; i < 8; ++i)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            int bit = 1 << axis;
+            if (i & bit)
+                continue;
+
+            // The faces adjacent to this edge are determined by the bits that do not change along it
+            int a = FACES[(axis + 1) % 3][(i >> ((axis + 1) % 3)) & 1];
+            int b = FACES[(axis + 2) % 3][(i >> ((axis + 2) % 3)) & 1];
+            if (facing[a] == facing[b])
+                continue;
+
+            XMVECTOR c0      = corners[i];
+            XMVECTOR c1      = corners[i | bit];
+            XMVECTOR toLight = light - c0 * XMVectorReplicate(lightW);
+            XMVECTOR normal  = XMVector3Cross(c1 - c0, toLight);
+            if (XMVectorGetX(XMVector3LengthSq(normal)) < FLT_EPSILON)
+                continue;   // Leaving out a plane only makes the volume larger
+
+            XMVECTOR plane = XMPlaneFromPointNormal(c0, normal);
+            if (XMVectorGetX(XMPlaneDotCoord(plane, center)) > 0.0f)
+                plane = XMVectorNegate(plane);
+
+            XMFLOAT4 p;
+            XMStoreFloat4(&p, plane);
+            volume.add(p);
+        }
+    }
+
+    return volume;
+}
+} // anonymous namespace
+
+namespace Dxx
+{
+//! @param	camera	The camera
+//! @param	light	The light
+
+CullingFrustum ShadowCasterVolume(Camera const & camera, DirectionalLight const & light)
+{
+    return ShadowCasterVolumeDirectional(camera.viewProjectionMatrix(), light.direction());
+}
+
+//! @param	camera	The camera
+//! @param	light	The light
+//!
+//! @note	The light's cone and range are not taken into account. The casters can also be culled against the light's
+//!			own frustum to take them into account.
+
+CullingFrustum ShadowCasterVolume(Camera const & camera, SpotLight const & light)
+{
+    return ShadowCasterVolumePositional(camera.viewProjectionMatrix(), light.position());
+}
+
+//! @param	viewProjection	The view-projection matrix of the view frustum
+//! @param	direction		The direction that the light travels
+
+CullingFrustum ShadowCasterVolumeDirectional(XMFLOAT4X4 const & viewProjection, XMFLOAT3 const & direction)
+{
+    // The frustum is swept toward the light, which is opposite to the direction that the light travels
+    return SweptVolume(viewProjection, XMVectorSet(-direction.x, -direction.y, -direction.z, 0.0f));
+}
+
+//! @param	viewProjection	The view-projection matrix of the view frustum
+//! @param	position		The position of the light
+
+CullingFrustum ShadowCasterVolumePositional(XMFLOAT4X4 const & viewProjection, XMFLOAT3 const & position)
+{
+    return SweptVolume(viewProjection, XMVectorSet(position.x, position.y, position.z, 1.0f));
+}
+} // namespace Dxx
@@ -0,0 +1,35 @@
+#pragma once
+
+#if !defined(DXX_SIMDLANES_H)
+#define DXX_SIMDLANES_H
+
+#include <cstdint>
+#include <DirectXMath.h>
+
+namespace Dxx
+{
+//! Loads the 4 values starting at p[i], padding past p[count - 1] with 0.
+inline DirectX::XMVECTOR Load4(float const * p, size_t i, size_t count)
+{
+    if (i + 4 <= count)
+        return DirectX::XMLoadFloat4(reinterpret_cast<DirectX::XMFLOAT4 const *>(p + i));
+
+    DirectX::XMFLOAT4 padded(0.0f, 0.0f, 0.0f, 0.0f);
+    float *           q = &padded.x;
+    for (size_t j = i; j < count; ++j)
+    {
+        q[j - i] = p[j];
+    }
+    return DirectX::XMLoadFloat4(&padded);
+}
+
+//! Returns the low bit of each lane of a comparison result packed into the low 4 bits.
+inline uint32_t LaneBits(DirectX::FXMVECTOR mask)
+{
+    uint32_t m[4];
+    DirectX::XMStoreInt4(m, mask);
+    return (m[0] & 1) | ((m[1] & 1) << 1) | ((m[2] & 1) << 2) | ((m[3] & 1) << 3);
+}
+} // namespace Dxx
+
+#endif // !defined(DXX_SIMDLANES_H)
@@ -0,0 +1,393 @@
+#include "SpatialHashGrid.h"
+
+#include "Camera.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+size_t constexpr   GRAIN        = 4096;                          // Number of points processed by a thread at a time
+size_t constexpr   MIN_CAPACITY = 64;                            // Minimum number of slots in the hash table
+int constexpr      CELL_BITS    = 21;                            // Number of bits in each coordinate of a cell
+int constexpr      MIN_CELL     = -(1 << (CELL_BITS - 1));       // Range of the coordinates of a cell
+int constexpr      MAX_CELL     = (1 << (CELL_BITS - 1)) - 1;
+uint64_t constexpr EMPTY        = ~0ull;                         // Key of an empty slot (not a valid key)
+
+// Returns the coordinate of the cell containing the value. Values outside of the range (including NaNs) are clamped.
+int CellCoordinate(float v, float invCellSize)
+{
+    float c = floorf(v * invCellSize);
+    if (!(c >= float(MIN_CELL)))
+        return MIN_CELL;
+    if (c > float(MAX_CELL))
+        return MAX_CELL;
+    return int(c);
+}
+
+// Returns the key of a cell
+uint64_t Pack(int x, int y, int z)
+{
+    uint64_t constexpr MASK = (1ull << CELL_BITS) - 1;
+    return (uint64_t(x - MIN_CELL) & MASK) << (2 * CELL_BITS) |
+           (uint64_t(y - MIN_CELL) & MASK) << CELL_BITS |
+           (uint64_t(z - MIN_CELL) & MASK);
+}
+
+// Returns the coordinates of a cell
+void Unpack(uint64_t key, int & x, int & y, int & z)
+{
+    uint64_t constexpr MASK = (1ull << CELL_BITS) - 1;
+    x = int((key >> (2 * CELL_BITS)) & MASK) + MIN_CELL;
+    y = int((key >> CELL_BITS) & MASK) + MIN_CELL;
+    z = int(key & MASK) + MIN_CELL;
+}
+
+// Returns the first slot to probe for a key
+uint32_t Hash(uint64_t key, uint32_t mask)
+{
+    return uint32_t((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+} // anonymous namespace
+
+namespace Dxx
+{
+//! @param	cellSize	Size of a cell. Queries are fastest when it is about the size of a typical query radius.
+
+SpatialHashGrid::SpatialHashGrid(float cellSize)
+    : cellSize_(cellSize)
+    , invCellSize_(1.0f / cellSize)
+    , cellCount_(0)
+{
+    assert(cellSize > 0.0f);
+    Grow(0);
+}
+
+//! Inserting points does not allocate memory until the total number of points exceeds the reserved number.
+//!
+//! @param	count	Total number of points
+
+void SpatialHashGrid::reserve(size_t count)
+{
+    positions_.reserve(count);
+    next_.reserve(count);
+    if (2 * count > keys_.size())
+        Grow(count);
+}
+
+void SpatialHashGrid::clear()
+{
+    positions_.clear();
+    next_.clear();
+    for (size_t i = 0; i < keys_.size(); ++i)
+    {
+        keys_[i].store(EMPTY, std::memory_order_relaxed);
+        heads_[i].store(NONE, std::memory_order_relaxed);
+    }
+    cellCount_ = 0;
+}
+
+//! The points are inserted in parallel.
+//!
+//! @param	pPositions	Positions of the points
+//! @param	count		Number of points
+//! @param	stride		Number of bytes from one position to the next
+
+void SpatialHashGrid::build(XMFLOAT3 const * pPositions, size_t count, size_t stride /*= sizeof(XMFLOAT3)*/)
+{
+    clear();
+    insert(pPositions, count, stride);
+}
+
+//! @param	position	Position of the point
+//!
+//! @return		The point's id
+
+uint32_t SpatialHashGrid::insert(XMFLOAT3 const & position)
+{
+    return insert(&position, 1);
+}
+
+//! The points are inserted in parallel.
+//!
+//! @param	pPositions	Positions of the points
+//! @param	count		Number of points
+//! @param	stride		Number of bytes from one position to the next
+//!
+//! @return		The id of the first point. The ids of the rest follow in order.
+
+uint32_t SpatialHashGrid::insert(XMFLOAT3 const * pPositions, size_t count, size_t stride /*= sizeof(XMFLOAT3)*/)
+{
+    size_t const first = positions_.size();
+    assert(first + count < NONE);
+
+    // Make sure that the table is no more than half full even if every point is in a new cell
+    if (2 * (cellCount_ + count) > keys_.size())
+        Grow(std::max(cellCount_ + count, keys_.size()));
+
+    positions_.resize(first + count);
+    next_.resize(first + count);
+
+    char const * pSource = reinterpret_cast<char const *>(pPositions);
+    ParallelFor(count, GRAIN, [&] (size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        memcpy(&positions_[first + i], pSource + i * stride, sizeof(XMFLOAT3));
+                    }
+                });
+
+    Link(first, first + count);
+    return uint32_t(first);
+}
+
+//! @param	center		Center of the sphere
+//! @param	radius		Radius of the sphere
+//! @param	results		The ids of the points inside the sphere are appended to this list
+
+void SpatialHashGrid::querySphere(XMFLOAT3 const & center, float radius, std::vector<uint32_t> & results) const
+{
+    int lo[3] =
+    {
+        CellCoordinate(center.x - radius, invCellSize_),
+        CellCoordinate(center.y - radius, invCellSize_),
+        CellCoordinate(center.z - radius, invCellSize_)
+    };
+    int hi[3] =
+    {
+        CellCoordinate(center.x + radius, invCellSize_),
+        CellCoordinate(center.y + radius, invCellSize_),
+        CellCoordinate(center.z + radius, invCellSize_)
+    };
+
+    float const radius2 = radius * radius;
+    ForEachCell(lo, hi, [&] (uint32_t slot, int, int, int) {
+                    for (uint32_t id = heads_[slot].load(std::memory_order_relaxed); id != NONE; id = next_[id])
+                    {
+                        XMFLOAT3 const & p  = positions_[id];
+                        float            dx = p.x - center.x;
+                        float            dy = p.y - center.y;
+                        float            dz = p.z - center.z;
+                        if (dx * dx + dy * dy + dz * dz <= radius2)
+                            results.push_back(id);
+                    }
+                });
+}
+
+//! Only the cells overlapping the bounding box of the frustum are checked.
+//!
+//! @param	camera		The camera
+//! @param	results		The ids of the points inside the camera's view frustum are appended to this list
+
+void SpatialHashGrid::queryFrustum(Camera const & camera, std::vector<uint32_t> & results) const
+{
+    XMFLOAT4X4 viewProjection = camera.viewProjectionMatrix();
+
+    // Compute the bounds of the frustum by transforming the corners of the clip volume back into world space
+
+    XMMATRIX inverse = XMMatrixInverse(nullptr, XMLoadFloat4x4(&viewProjection));
+    XMVECTOR minimum = XMVectorReplicate(FLT_MAX);
+    XMVECTOR maximum = XMVectorReplicate(-FLT_MAX);
+    for (int i = 0; i < 8; ++i)
+    {
+        XMVECTOR ndc    = XMVectorSet((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : 0.0f, 1.0f);
+        XMVECTOR corner = XMVector3TransformCoord(ndc, inverse);
+        minimum = XMVectorMin(minimum, corner);
+        maximum = XMVectorMax(maximum, corner);
+    }
+
+    XMFLOAT3 min;
+    XMFLOAT3 max;
+    XMStoreFloat3(&min, minimum);
+    XMStoreFloat3(&max, maximum);
+
+    int lo[3] =
+    {
+        CellCoordinate(min.x, invCellSize_),
+        CellCoordinate(min.y, invCellSize_),
+        CellCoordinate(min.z, invCellSize_)
+    };
+    int hi[3] =
+    {
+        CellCoordinate(max.x, invCellSize_),
+        CellCoordinate(max.y, invCellSize_),
+        CellCoordinate(max.z, invCellSize_)
+    };
+
+    QueryFrustum(CullingFrustum(viewProjection), lo, hi, results);
+}
+
+//! Since the volume may be unbounded, every non-empty cell is checked.
+//!
+//! @param	frustum		Culling volume
+//! @param	results		The ids of the points inside the volume are appended to this list
+
+void SpatialHashGrid::queryFrustum(CullingFrustum const & frustum, std::vector<uint32_t> & results) const
+{
+    int lo[3] = { MIN_CELL, MIN_CELL, MIN_CELL };
+    int hi[3] = { MAX_CELL, MAX_CELL, MAX_CELL };
+    QueryFrustum(frustum, lo, hi, results);
+}
+
+void SpatialHashGrid::Link(size_t begin, size_t end)
+{
+    uint32_t const mask = uint32_t(keys_.size() - 1);
+
+    ParallelFor(end - begin, GRAIN, [&] (size_t b, size_t e) {
+                    for (size_t i = begin + b; i < begin + e; ++i)
+                    {
+                        XMFLOAT3 const & p   = positions_[i];
+                        uint64_t const   key = Pack(CellCoordinate(p.x, invCellSize_),
+                                                    CellCoordinate(p.y, invCellSize_),
+                                                    CellCoordinate(p.z, invCellSize_));
+
+                        // Find the cell's slot, claiming an empty slot if the cell is not in the table yet. If another
+                        // thread claims the slot first, the slot is still this cell's slot if it claimed it for the
+                        // same cell.
+                        uint32_t slot = Hash(key, mask);
+                        for (;;)
+                        {
+                            uint64_t k = keys_[slot].load(std::memory_order_relaxed);
+                            if (k == EMPTY)
+                            {
+                                if (keys_[slot].compare_exchange_strong(k, key, std::memory_order_relaxed))
+                                {
+                                    ++cellCount_;
+                                    break;
+                                }
+                            }
+                            if (k == key)
+                                break;
+                            slot = (slot + 1) & mask;
+                        }
+
+                        next_[i] = heads_[slot].exchange(uint32_t(i), std::memory_order_relaxed);
+                    }
+                });
+}
+
+void SpatialHashGrid::Grow(size_t cellCount)
+{
+    size_t capacity = MIN_CAPACITY;
+    while (capacity < 2 * cellCount)
+    {
+        capacity *= 2;
+    }
+
+    std::vector<std::atomic<uint64_t> >(capacity).swap(keys_);
+    std::vector<std::atomic<uint32_t> >(capacity).swap(heads_);
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        keys_[i].store(EMPTY, std::memory_order_relaxed);
+        heads_[i].store(NONE, std::memory_order_relaxed);
+    }
+    cellCount_ = 0;
+
+    Link(0, positions_.size());
+}
+
+uint32_t SpatialHashGrid::Find(uint64_t key) const
+{
+    uint32_t const mask = uint32_t(keys_.size() - 1);
+    for (uint32_t slot = Hash(key, mask);; slot = (slot + 1) & mask)
+    {
+        uint64_t k = keys_[slot].load(std::memory_order_relaxed);
+        if (k == key)
+            return slot;
+        if (k == EMPTY)
+            return NONE;
+    }
+}
+
+void SpatialHashGrid::QueryFrustum(CullingFrustum const &  frustum,
+                                   int const               lo[3],
+                                   int const               hi[3],
+                                   std::vector<uint32_t> & results) const
+{
+    float const halfSize = cellSize_ * 0.5f;
+
+    ForEachCell(lo, hi, [&] (uint32_t slot, int x, int y, int z) {
+                    // Points outside of the range of cell coordinates are clamped into the cells on its boundary, so
+                    // the bounds of those cells cannot be used to cull their points.
+                    uint32_t planes = (1u << frustum.size()) - 1;
+                    if (x > MIN_CELL && x < MAX_CELL && y > MIN_CELL && y < MAX_CELL && z > MIN_CELL && z < MAX_CELL)
+                    {
+                        float cx = (float(x) + 0.5f) * cellSize_;
+                        float cy = (float(y) + 0.5f) * cellSize_;
+                        float cz = (float(z) + 0.5f) * cellSize_;
+                        for (int i = 0; i < frustum.size(); ++i)
+                        {
+                            XMFLOAT4 const & p        = frustum.plane(i);
+                            float            radius   = (fabsf(p.x) + fabsf(p.y) + fabsf(p.z)) * halfSize;
+                            float            distance = p.x * cx + p.y * cy + p.z * cz + p.w;
+                            if (distance > radius)
+                                return;
+                            if (distance < -radius)
+                                planes &= ~(1u << i);
+                        }
+                    }
+
+                    // Test the points in the cell against the planes that the cell is not completely inside of
+
+                    for (uint32_t id = heads_[slot].load(std::memory_order_relaxed); id != NONE; id = next_[id])
+                    {
+                        XMFLOAT3 const & o      = positions_[id];
+                        bool             inside = true;
+                        for (int i = 0; i < frustum.size() && inside; ++i)
+                        {
+                            if (!(planes & (1u << i)))
+                                continue;
+
+                            XMFLOAT4 const & p = frustum.plane(i);
+                            inside = p.x * o.x + p.y * o.y + p.z * o.z + p.w <= 0.0f;
+                        }
+                        if (inside)
+                            results.push_back(id);
+                    }
+                });
+}
+
+template <typename Function>
+void SpatialHashGrid::ForEachCell(int const lo[3], int const hi[3], Function f) const
+{
+    double volume = double(hi[0] - lo[0] + 1) * double(hi[1] - lo[1] + 1) * double(hi[2] - lo[2] + 1);
+    if (volume <= double(cellCount_))
+    {
+        // Look up each cell in the range
+        for (int z = lo[2]; z <= hi[2]; ++z)
+        {
+            for (int y = lo[1]; y <= hi[1]; ++y)
+            {
+                for (int x = lo[0]; x <= hi[0]; ++x)
+                {
+                    uint32_t slot = Find(Pack(x, y, z));
+                    if (slot != NONE)
+                        f(slot, x, y, z);
+                }
+            }
+        }
+    }
+    else
+    {
+        // The range contains more cells than the table does, so check each cell in the table instead
+        for (uint32_t slot = 0; slot < uint32_t(keys_.size()); ++slot)
+        {
+            uint64_t key = keys_[slot].load(std::memory_order_relaxed);
+            if (key == EMPTY)
+                continue;
+
+            int x;
+            int y;
+            int z;
+            Unpack(key, x, y, z);
+            if (x >= lo[0] && x <= hi[0] && y >= lo[1] && y <= hi[1] && z >= lo[2] && z <= hi[2])
+                f(slot, x, y, z);
+        }
+    }
+}
+} // namespace Dxx
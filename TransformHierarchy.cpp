@@ -0,0 +1,246 @@
+#include "TransformHierarchy.h"
+
+#include "ParallelFor.h"
+
+#include <cassert>
+
+using namespace DirectX;
+
+namespace
+{
+size_t constexpr GRAIN = 1024;  // Number of nodes updated by a thread at a time
+
+// Reorders the elements of a vector so that element i is the element that was at order[i]
+template <typename T>
+void Permute(std::vector<T> & v, std::vector<uint32_t> const & order)
+{
+    std::vector<T> permuted;
+    permuted.reserve(v.size());
+    for (uint32_t old : order)
+    {
+        permuted.push_back(v[old]);
+    }
+    v.swap(permuted);
+}
+} // anonymous namespace
+
+namespace Dxx
+{
+TransformHierarchy::TransformHierarchy()
+    : stamp_(0)
+    , updateCount_(0)
+    , sorted_(true)
+{
+}
+
+//! @param	count	Total number of nodes
+
+void TransformHierarchy::reserve(size_t count)
+{
+    locals_.reserve(count);
+    worlds_.reserve(count);
+    parents_.reserve(count);
+    firstChildren_.reserve(count);
+    childCounts_.reserve(count);
+    depths_.reserve(count);
+    stamps_.reserve(count);
+    ids_.reserve(count);
+    slots_.reserve(count);
+}
+
+//! The node's world transformation is not valid until update() is called.
+//!
+//! @param	local	The node's frame of reference relative to its parent
+//! @param	parent	The parent's id, or NONE if the node is a root
+//!
+//! @return		The node's id
+
+uint32_t TransformHierarchy::add(Frame const & local, uint32_t parent /*= NONE*/)
+{
+    assert(parent == NONE || parent < slots_.size());
+
+    uint32_t const id         = uint32_t(slots_.size());
+    uint32_t const parentSlot = (parent != NONE) ? slots_[parent] : NONE;
+
+    locals_.push_back(local);
+    worlds_.emplace_back();
+    parents_.push_back(parentSlot);
+    firstChildren_.push_back(0);
+    childCounts_.push_back(0);
+    depths_.push_back((parentSlot != NONE) ? depths_[parentSlot] + 1 : 0);
+    stamps_.push_back(0);
+    ids_.push_back(id);
+    slots_.push_back(id);
+
+    changed_.push_back(id);
+    sorted_ = false;
+    return id;
+}
+
+//! The world transformations of the node and its descendants are recomputed by the next call to update().
+//!
+//! @param	id		The node's id
+//! @param	local	The node's frame of reference relative to its parent
+
+void TransformHierarchy::setLocal(uint32_t id, Frame const & local)
+{
+    locals_[slots_[id]] = local;
+    changed_.push_back(id);
+}
+
+//! @param	id		The node's id
+
+uint32_t TransformHierarchy::parent(uint32_t id) const
+{
+    uint32_t p = parents_[slots_[id]];
+    return (p != NONE) ? ids_[p] : NONE;
+}
+
+void TransformHierarchy::update()
+{
+    if (!sorted_)
+        Sort();
+
+    ++stamp_;
+    updateCount_ = 0;
+
+    // Sort the changed nodes by depth
+
+    for (uint32_t id : changed_)
+    {
+        uint32_t slot  = slots_[id];
+        uint32_t depth = depths_[slot];
+        if (levels_.size() <= depth)
+            levels_.resize(depth + 1);
+        levels_[depth].push_back(slot);
+    }
+    changed_.clear();
+
+    // Update each level, starting at the top. The nodes to update at each level are the changed nodes at that level
+    // and the children of the nodes updated at the level above.
+
+    for (size_t depth = 0; depth < levels_.size(); ++depth)
+    {
+        std::vector<uint32_t> & level = levels_[depth];
+
+        // Remove the nodes that are listed more than once
+        size_t n = 0;
+        for (uint32_t slot : level)
+        {
+            if (stamps_[slot] != stamp_)
+            {
+                stamps_[slot] = stamp_;
+                level[n++]    = slot;
+            }
+        }
+        level.resize(n);
+        if (n == 0)
+            continue;
+
+        ParallelFor(n, GRAIN, [&] (size_t begin, size_t end) {
+                        for (size_t i = begin; i < end; ++i)
+                        {
+                            uint32_t   slot  = level[i];
+                            XMFLOAT4X4 local = locals_[slot].transformation();
+                            XMMATRIX   world = XMLoadFloat4x4(&local);
+                            uint32_t   p     = parents_[slot];
+                            if (p != NONE)
+                                world = XMMatrixMultiply(world, XMLoadFloat4x4(&worlds_[p]));
+                            XMStoreFloat4x4(&worlds_[slot], world);
+                        }
+                    });
+        updateCount_ += n;
+
+        // The children of the updated nodes must be updated too. The children of each node are consecutive. Note
+        // that resizing levels_ invalidates the reference to the level.
+        if (levels_.size() <= depth + 1)
+            levels_.resize(depth + 2);
+        std::vector<uint32_t> & next = levels_[depth + 1];
+        for (uint32_t slot : levels_[depth])
+        {
+            for (uint32_t c = firstChildren_[slot]; c < firstChildren_[slot] + childCounts_[slot]; ++c)
+            {
+                next.push_back(c);
+            }
+        }
+    }
+
+    for (auto & level : levels_)
+    {
+        level.clear();
+    }
+}
+
+void TransformHierarchy::Sort()
+{
+    size_t const n = locals_.size();
+
+    // List the children of each node
+
+    std::vector<uint32_t> offsets(n + 1, 0);
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (parents_[i] != NONE)
+            ++offsets[parents_[i] + 1];
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        offsets[i + 1] += offsets[i];
+    }
+
+    std::vector<uint32_t> children(n);
+    std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (parents_[i] != NONE)
+            children[next[parents_[i]]++] = uint32_t(i);
+    }
+
+    // The roots come first, then the children of each node in order. This is a breadth-first traversal, so the nodes
+    // are sorted by depth and the children of each node are consecutive.
+
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (parents_[i] == NONE)
+            order.push_back(uint32_t(i));
+    }
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        uint32_t old = order[i];
+        order.insert(order.end(), children.begin() + offsets[old], children.begin() + offsets[old + 1]);
+    }
+    assert(order.size() == n);
+
+    std::vector<uint32_t> positions(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        positions[order[i]] = uint32_t(i);
+    }
+
+    Permute(locals_, order);
+    Permute(worlds_, order);
+    Permute(depths_, order);
+    Permute(stamps_, order);
+    Permute(ids_, order);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint32_t old    = order[i];
+        uint32_t parent = parents_[old];
+        uint32_t count  = offsets[old + 1] - offsets[old];
+        firstChildren_[i] = (count > 0) ? positions[children[offsets[old]]] : 0;
+        childCounts_[i]   = count;
+        next[i]           = (parent != NONE) ? positions[parent] : NONE;
+    }
+    parents_.swap(next);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        slots_[ids_[i]] = uint32_t(i);
+    }
+
+    sorted_ = true;
+}
+} // namespace Dxx
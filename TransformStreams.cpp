@@ -0,0 +1,272 @@
+#include "TransformStreams.h"
+
+#include "Camera.h"
+#include "Frame.h"
+#include "ParallelFor.h"
+#include "TransformStreamsAvx2.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+size_t constexpr GRAIN = 4096;  // Number of vectors transformed by a thread at a time (a multiple of 8)
+size_t constexpr BLOCK = 256;   // Number of points transformed into a temporary buffer at a time
+
+// Returns the address of element i of an array with the given stride
+template <typename T>
+T * Element(T * p, size_t stride, size_t i)
+{
+    return reinterpret_cast<T *>(reinterpret_cast<uintptr_t>(p) + i * stride);
+}
+
+// Returns true if the processor and the operating system support AVX2 and FMA
+bool HasAvx2()
+{
+#if defined(_XM_SSE_INTRINSICS_) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    __cpuid(info, 1);
+    bool const fma     = (info[2] & (1 << 12)) != 0;
+    bool const osxsave = (info[2] & (1 << 27)) != 0;
+    bool const avx     = (info[2] & (1 << 28)) != 0;
+    if (!fma || !osxsave || !avx)
+        return false;
+
+    // The operating system must save the XMM and YMM registers
+    if ((_xgetbv(0) & 0x6) != 0x6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(_XM_SSE_INTRINSICS_) && defined(__GNUC__)
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+// Returns true if the AVX2 kernel is used. The processor is only checked the first time.
+bool UseAvx2()
+{
+    static bool const avx2 = HasAvx2();
+    return avx2;
+}
+
+// Transforms points with the DirectXMath stream function. The transform's last column is (0, 0, 0, 1), so the W
+// components are 1 and are simply dropped, rather than divided by.
+void TransformPointsSse(XMFLOAT3 const * pIn,
+                        size_t           inStride,
+                        size_t           count,
+                        XMFLOAT3 *       pOut,
+                        size_t           outStride,
+                        FXMMATRIX        m)
+{
+    XMFLOAT4 results[BLOCK];
+    for (size_t i = 0; i < count; i += BLOCK)
+    {
+        size_t const n = std::min(BLOCK, count - i);
+        XMVector3TransformStream(results, sizeof(XMFLOAT4), Element(pIn, inStride, i), inStride, n, m);
+        for (size_t j = 0; j < n; ++j)
+        {
+            *Element(pOut, outStride, i + j) = XMFLOAT3(results[j].x, results[j].y, results[j].z);
+        }
+    }
+}
+} // anonymous namespace
+
+namespace Dxx
+{
+//! @param	frame		The frame
+//! @param	pIn			Points to transform
+//! @param	inStride	Distance in bytes between consecutive input points
+//! @param	count		Number of points
+//! @param	pOut		Where to store the transformed points
+//! @param	outStride	Distance in bytes between consecutive output points
+
+void TransformPoints(Frame const &    frame,
+                     XMFLOAT3 const * pIn,
+                     size_t           inStride,
+                     size_t           count,
+                     XMFLOAT3 *       pOut,
+                     size_t           outStride)
+{
+    XMFLOAT4X4 const m      = frame.transformation();
+    XMMATRIX const   m_simd = XMLoadFloat4x4(&m);
+
+    bool const avx2 = UseAvx2();
+
+    ParallelFor(count, GRAIN, [&] (size_t begin, size_t end) {
+                    if (avx2)
+                    {
+                        TransformStreamAvx2(m,
+                                            1.0f,
+                                            Element(pIn, inStride, begin),
+                                            inStride,
+                                            end - begin,
+                                            &Element(pOut, outStride, begin)->x,
+                                            outStride,
+                                            3);
+                    }
+                    else
+                    {
+                        TransformPointsSse(Element(pIn, inStride, begin),
+                                           inStride,
+                                           end - begin,
+                                           Element(pOut, outStride, begin),
+                                           outStride,
+                                           m_simd);
+                    }
+                });
+}
+
+//! @param	frame		The frame
+//! @param	pIn			Directions to transform
+//! @param	inStride	Distance in bytes between consecutive input directions
+//! @param	count		Number of directions
+//! @param	pOut		Where to store the transformed directions
+//! @param	outStride	Distance in bytes between consecutive output directions
+
+void TransformDirections(Frame const &    frame,
+                         XMFLOAT3 const * pIn,
+                         size_t           inStride,
+                         size_t           count,
+                         XMFLOAT3 *       pOut,
+                         size_t           outStride)
+{
+    XMFLOAT4X4 const m      = frame.transformation();
+    XMMATRIX const   m_simd = XMLoadFloat4x4(&m);
+
+    bool const avx2 = UseAvx2();
+
+    ParallelFor(count, GRAIN, [&] (size_t begin, size_t end) {
+                    if (avx2)
+                    {
+                        TransformStreamAvx2(m,
+                                            0.0f,
+                                            Element(pIn, inStride, begin),
+                                            inStride,
+                                            end - begin,
+                                            &Element(pOut, outStride, begin)->x,
+                                            outStride,
+                                            3);
+                    }
+                    else
+                    {
+                        XMVector3TransformNormalStream(Element(pOut, outStride, begin),
+                                                       outStride,
+                                                       Element(pIn, inStride, begin),
+                                                       inStride,
+                                                       end - begin,
+                                                       m_simd);
+                    }
+                });
+}
+
+//! Normals are transformed by the inverse transpose of the frame's transformation, so they remain perpendicular to
+//! their surfaces when the scale is not uniform.
+//!
+//! @param	frame		The frame
+//! @param	pIn			Normals to transform
+//! @param	inStride	Distance in bytes between consecutive input normals
+//! @param	count		Number of normals
+//! @param	pOut		Where to store the transformed normals
+//! @param	outStride	Distance in bytes between consecutive output normals
+
+void TransformNormals(Frame const &    frame,
+                      XMFLOAT3 const * pIn,
+                      size_t           inStride,
+                      size_t           count,
+                      XMFLOAT3 *       pOut,
+                      size_t           outStride)
+{
+    XMFLOAT4X4 const m      = frame.transformation();
+    XMMATRIX const   n_simd = XMMatrixTranspose(XMMatrixInverse(nullptr, XMLoadFloat4x4(&m)));
+    XMFLOAT4X4       n;
+    XMStoreFloat4x4(&n, n_simd);
+
+    bool const avx2 = UseAvx2();
+
+    ParallelFor(count, GRAIN, [&] (size_t begin, size_t end) {
+                    if (avx2)
+                    {
+                        TransformStreamAvx2(n,
+                                            0.0f,
+                                            Element(pIn, inStride, begin),
+                                            inStride,
+                                            end - begin,
+                                            &Element(pOut, outStride, begin)->x,
+                                            outStride,
+                                            3);
+                    }
+                    else
+                    {
+                        XMVector3TransformNormalStream(Element(pOut, outStride, begin),
+                                                       outStride,
+                                                       Element(pIn, inStride, begin),
+                                                       inStride,
+                                                       end - begin,
+                                                       n_simd);
+                    }
+
+                    // The results are normalized while they are still in the cache
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        XMFLOAT3 * pNormal = Element(pOut, outStride, i);
+                        XMStoreFloat3(pNormal, XMVector3Normalize(XMLoadFloat3(pNormal)));
+                    }
+                });
+}
+
+//! @param	camera		The camera
+//! @param	pIn			Points to transform
+//! @param	inStride	Distance in bytes between consecutive input points
+//! @param	count		Number of points
+//! @param	pOut		Where to store the points in clip space
+//! @param	outStride	Distance in bytes between consecutive output points
+
+void TransformToClipSpace(Camera const &   camera,
+                          XMFLOAT3 const * pIn,
+                          size_t           inStride,
+                          size_t           count,
+                          XMFLOAT4 *       pOut,
+                          size_t           outStride)
+{
+    XMFLOAT4X4 const m      = camera.viewProjectionMatrix();
+    XMMATRIX const   m_simd = XMLoadFloat4x4(&m);
+
+    bool const avx2 = UseAvx2();
+
+    ParallelFor(count, GRAIN, [&] (size_t begin, size_t end) {
+                    if (avx2)
+                    {
+                        TransformStreamAvx2(m,
+                                            1.0f,
+                                            Element(pIn, inStride, begin),
+                                            inStride,
+                                            end - begin,
+                                            &Element(pOut, outStride, begin)->x,
+                                            outStride,
+                                            4);
+                    }
+                    else
+                    {
+                        XMVector3TransformStream(Element(pOut, outStride, begin),
+                                                 outStride,
+                                                 Element(pIn, inStride, begin),
+                                                 inStride,
+                                                 end - begin,
+                                                 m_simd);
+                    }
+                });
+}
+} // namespace Dxx
@@ -0,0 +1,99 @@
+// This file is compiled with AVX2 and FMA enabled. Nothing in it may be called unless the processor supports them.
+
+#include "TransformStreamsAvx2.h"
+
+#include <climits>
+#include <cstdint>
+
+#if defined(_XM_SSE_INTRINSICS_)
+#include <immintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+// Returns the address of element i of an array with the given stride
+template <typename T>
+T * Element(T * p, size_t stride, size_t i)
+{
+    return reinterpret_cast<T *>(reinterpret_cast<uintptr_t>(p) + i * stride);
+}
+
+// Transforms one vector (which is passed by value, since the output may overwrite the input)
+void Transform1(XMFLOAT4X4 const & m, float w, XMFLOAT3 v, float * pOut, int components)
+{
+    for (int c = 0; c < components; ++c)
+    {
+        pOut[c] = v.x * m.m[0][c] + v.y * m.m[1][c] + v.z * m.m[2][c] + w * m.m[3][c];
+    }
+}
+} // anonymous namespace
+
+namespace Dxx
+{
+void TransformStreamAvx2(XMFLOAT4X4 const & m,
+                         float              w,
+                         XMFLOAT3 const *   pIn,
+                         size_t             inStride,
+                         size_t             count,
+                         float *            pOut,
+                         size_t             outStride,
+                         int                components)
+{
+    size_t i = 0;
+
+#if defined(_XM_SSE_INTRINSICS_)
+    // The inputs are gathered with 32-bit offsets, so vectors that are too far apart are transformed one at a time
+    if (inStride <= size_t(INT_MAX / 8))
+    {
+        // Each element of the matrix, replicated across all 8 lanes. The W row is pre-multiplied by w.
+        __m256 mx[4];
+        __m256 my[4];
+        __m256 mz[4];
+        __m256 mw[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            mx[c] = _mm256_set1_ps(m.m[0][c]);
+            my[c] = _mm256_set1_ps(m.m[1][c]);
+            mz[c] = _mm256_set1_ps(m.m[2][c]);
+            mw[c] = _mm256_set1_ps(w * m.m[3][c]);
+        }
+
+        int const     stride  = int(inStride);
+        __m256i const offsets = _mm256_setr_epi32(0, stride, 2 * stride, 3 * stride,
+                                                  4 * stride, 5 * stride, 6 * stride, 7 * stride);
+
+        for (; i + 8 <= count; i += 8)
+        {
+            float const * pX = &Element(pIn, inStride, i)->x;
+            __m256        x  = _mm256_i32gather_ps(pX, offsets, 1);
+            __m256        y  = _mm256_i32gather_ps(pX + 1, offsets, 1);
+            __m256        z  = _mm256_i32gather_ps(pX + 2, offsets, 1);
+
+            alignas(32) float results[4][8];
+            for (int c = 0; c < components; ++c)
+            {
+                __m256 r = _mm256_fmadd_ps(x, mx[c], _mm256_fmadd_ps(y, my[c], _mm256_fmadd_ps(z, mz[c], mw[c])));
+                _mm256_store_ps(results[c], r);
+            }
+
+            // There is no scatter in AVX2, so the results are stored one at a time
+            for (int j = 0; j < 8; ++j)
+            {
+                float * pResult = Element(pOut, outStride, i + j);
+                for (int c = 0; c < components; ++c)
+                {
+                    pResult[c] = results[c][j];
+                }
+            }
+        }
+    }
+#endif // defined(_XM_SSE_INTRINSICS_)
+
+    for (; i < count; ++i)
+    {
+        Transform1(m, w, *Element(pIn, inStride, i), Element(pOut, outStride, i), components);
+    }
+}
+} // namespace Dxx
@@ -0,0 +1,35 @@
+#pragma once
+
+#if !defined(DXX_TRANSFORMSTREAMSAVX2_H)
+#define DXX_TRANSFORMSTREAMSAVX2_H
+
+#include <DirectXMath.h>
+
+namespace Dxx
+{
+//! Transforms the vectors (x, y, z, w) by a matrix, 8 vectors at a time, using AVX2 and FMA.
+//!
+//! The input vectors are XMFLOAT3s and the given @a w is used for all of them. The first @a components components of
+//! each result are stored. This function is compiled with AVX2 enabled, so it must only be called if the processor
+//! supports AVX2 and FMA.
+//!
+//! @param	m			Transformation matrix
+//! @param	w			W component of the input vectors (1 for points and 0 for directions)
+//! @param	pIn			Vectors to transform
+//! @param	inStride	Distance in bytes between consecutive input vectors
+//! @param	count		Number of vectors
+//! @param	pOut		Where to store the results
+//! @param	outStride	Distance in bytes between consecutive results
+//! @param	components	Number of components of each result to store (3 or 4)
+
+void TransformStreamAvx2(DirectX::XMFLOAT4X4 const & m,
+                         float                       w,
+                         DirectX::XMFLOAT3 const *   pIn,
+                         size_t                      inStride,
+                         size_t                      count,
+                         float *                     pOut,
+                         size_t                      outStride,
+                         int                         components);
+} // namespace Dxx
+
+#endif // !defined(DXX_TRANSFORMSTREAMSAVX2_H)
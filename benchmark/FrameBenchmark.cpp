@@ -0,0 +1,167 @@
+// Compares the cost of Frame's accessors and setters with the previous implementation, which stored only the
+// transformation matrix and decomposed it on every access.
+
+#include "Dxx/Frame.h"
+
+#include <DirectXMath.h>
+
+#include <chrono>
+#include <cstdio>
+
+using namespace DirectX;
+
+namespace
+{
+int constexpr ITERATIONS = 1000000;     // Number of calls timed for each operation
+
+// The previous implementation of Frame, which stores only the transformation matrix
+class MatrixFrame
+{
+public:
+
+    MatrixFrame(XMFLOAT3 const & translation, XMFLOAT4 const & rotation, XMFLOAT3 const & scale)
+    {
+        XMMATRIX m_simd = XMMatrixScaling(scale.x, scale.y, scale.z)
+                          * XMMatrixRotationQuaternion(XMLoadFloat4(&rotation))
+                          * XMMatrixTranslation(translation.x, translation.y, translation.z);
+        XMStoreFloat4x4(&m_, m_simd);
+    }
+
+    XMFLOAT3 translation() const
+    {
+        XMVECTOR s_simd;
+        XMVECTOR r_simd;
+        XMVECTOR t_simd;
+        XMMatrixDecompose(&s_simd, &r_simd, &t_simd, XMLoadFloat4x4(&m_));
+
+        XMFLOAT3 t;
+        XMStoreFloat3(&t, t_simd);
+        return t;
+    }
+
+    XMFLOAT4 orientation() const
+    {
+        XMVECTOR s_simd;
+        XMVECTOR r_simd;
+        XMVECTOR t_simd;
+        XMMatrixDecompose(&s_simd, &r_simd, &t_simd, XMLoadFloat4x4(&m_));
+
+        XMFLOAT4 r;
+        XMStoreFloat4(&r, r_simd);
+        return r;
+    }
+
+    XMFLOAT3 scale() const
+    {
+        XMVECTOR s_simd;
+        XMVECTOR r_simd;
+        XMVECTOR t_simd;
+        XMMatrixDecompose(&s_simd, &r_simd, &t_simd, XMLoadFloat4x4(&m_));
+
+        XMFLOAT3 s;
+        XMStoreFloat3(&s, s_simd);
+        return s;
+    }
+
+    void setTranslation(XMFLOAT3 const & t)
+    {
+        XMVECTOR s_simd;
+        XMVECTOR r_simd;
+        XMVECTOR t_simd;
+        XMMatrixDecompose(&s_simd, &r_simd, &t_simd, XMLoadFloat4x4(&m_));
+        XMStoreFloat4x4(&m_,
+                        XMMatrixScalingFromVector(s_simd) * XMMatrixRotationQuaternion(r_simd)
+                        * XMMatrixTranslation(t.x, t.y, t.z));
+    }
+
+    void setOrientation(XMFLOAT4 const & r)
+    {
+        XMVECTOR s_simd;
+        XMVECTOR r_simd;
+        XMVECTOR t_simd;
+        XMMatrixDecompose(&s_simd, &r_simd, &t_simd, XMLoadFloat4x4(&m_));
+        XMStoreFloat4x4(&m_,
+                        XMMatrixScalingFromVector(s_simd) * XMMatrixRotationQuaternion(XMLoadFloat4(&r))
+                        * XMMatrixTranslationFromVector(t_simd));
+    }
+
+    void setScale(XMFLOAT3 const & s)
+    {
+        XMVECTOR s_simd;
+        XMVECTOR r_simd;
+        XMVECTOR t_simd;
+        XMMatrixDecompose(&s_simd, &r_simd, &t_simd, XMLoadFloat4x4(&m_));
+        XMStoreFloat4x4(&m_,
+                        XMMatrixScaling(s.x, s.y, s.z) * XMMatrixRotationQuaternion(r_simd)
+                        * XMMatrixTranslationFromVector(t_simd));
+    }
+
+    XMFLOAT4X4 transformation() const { return m_; }
+
+private:
+
+    XMFLOAT4X4 m_;
+};
+
+float sink = 0.0f;  // Results are accumulated here so that the calls are not optimized away
+
+// Returns the average time of a call to f in nanoseconds
+template <typename Function>
+double Time(Function f)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        f(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / double(ITERATIONS);
+}
+
+// Times an operation on both implementations and prints the results
+template <typename Before, typename After>
+void Compare(char const * name, Before before, After after)
+{
+    double b = Time(before);
+    double a = Time(after);
+    printf("%-20s %10.1f ns %10.1f ns %8.1fx\n", name, b, a, b / a);
+}
+} // anonymous namespace
+
+int main()
+{
+    XMFLOAT3 const translation(1.0f, 2.0f, 3.0f);
+    XMFLOAT4 const rotation(0.0f, 0.38268343f, 0.0f, 0.92387953f);
+    XMFLOAT3 const scale(2.0f, 2.0f, 2.0f);
+
+    MatrixFrame before(translation, rotation, scale);
+    Dxx::Frame  after(translation, rotation, scale);
+
+    printf("%-20s %13s %13s %9s\n", "", "before", "after", "speedup");
+
+    Compare("translation()",
+            [&] (int) { sink += before.translation().x; },
+            [&] (int) { sink += after.translation().x; });
+    Compare("orientation()",
+            [&] (int) { sink += before.orientation().y; },
+            [&] (int) { sink += after.orientation().y; });
+    Compare("scale()",
+            [&] (int) { sink += before.scale().z; },
+            [&] (int) { sink += after.scale().z; });
+    Compare("transformation()",
+            [&] (int) { sink += before.transformation()._41; },
+            [&] (int) { sink += after.transformation()._41; });
+    Compare("setTranslation()",
+            [&] (int i) { before.setTranslation(XMFLOAT3(float(i), 2.0f, 3.0f)); },
+            [&] (int i) { after.setTranslation(XMFLOAT3(float(i), 2.0f, 3.0f)); });
+    Compare("setOrientation()",
+            [&] (int) { before.setOrientation(rotation); },
+            [&] (int) { after.setOrientation(rotation); });
+    Compare("setScale()",
+            [&] (int i) { before.setScale(XMFLOAT3(1.0f + float(i & 1), 2.0f, 2.0f)); },
+            [&] (int i) { after.setScale(XMFLOAT3(1.0f + float(i & 1), 2.0f, 2.0f)); });
+
+    sink += before.transformation()._41 + after.transformation()._41;
+    printf("(%g)\n", sink);
+    return 0;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#if !defined(DXX_AFFINEFRAME_H)
+#define DXX_AFFINEFRAME_H
+
+#include <DirectXMath.h>
+
+namespace Dxx
+{
+class Frame;
+
+//! A compact frame of reference including translation, scale, and orientation.
+//!
+//! The last column of a frame's transformation matrix is always (0, 0, 0, 1), so only the other three columns are
+//! stored, as the rows of an aligned 3x4 matrix (48 bytes instead of 64). Unlike Frame, the translation, orientation,
+//! and scale are not stored separately, so only the translation can be read without decomposing the matrix.
+//! Composition, inversion, and transforming points skip the constant column.
+//!
+//! @ingroup	D3dx
+//!
+
+class AffineFrame
+{
+public:
+
+    //! Constructor.
+    constexpr AffineFrame()
+        : m_(1.0f, 0.0f, 0.0f, 0.0f,
+             0.0f, 1.0f, 0.0f, 0.0f,
+             0.0f, 0.0f, 1.0f, 0.0f)
+    {
+    }
+
+    //! Constructor.
+    AffineFrame(DirectX::XMFLOAT3 const & translation,
+                DirectX::XMFLOAT4 const & rotation,
+                DirectX::XMFLOAT3 const & scale = DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f));
+
+    //! Constructor. The last column of the matrix is ignored.
+    explicit AffineFrame(DirectX::XMFLOAT4X4 const & m);
+
+    //! Constructor.
+    explicit AffineFrame(Frame const & frame);
+
+    //! Translates the frame and returns it.
+    AffineFrame & translate(DirectX::XMFLOAT3 const & t);
+
+    //! Rotates the frame by the given quaternion and returns it.
+    AffineFrame & rotate(DirectX::XMFLOAT4 const & r);
+
+    //! Scales the frame and returns it.
+    AffineFrame & scale(DirectX::XMFLOAT3 const & s);
+
+    //! Sets the frame's translation.
+    void setTranslation(DirectX::XMFLOAT3 const & t);
+
+    //! Returns the frame's translation.
+    DirectX::XMFLOAT3 translation() const { return DirectX::XMFLOAT3(m_._14, m_._24, m_._34); }
+
+    //! Sets the frame's transformation matrix. The last column of the matrix is ignored.
+    void setTransformation(DirectX::XMFLOAT4X4 const & m);
+
+    //! Returns the frame's transformation matrix.
+    DirectX::XMFLOAT4X4 transformation() const;
+
+    //! Returns the frame's transformation as a transposed 3x4 matrix.
+    DirectX::XMFLOAT3X4A const & transposed() const { return m_; }
+
+    //! Returns the frame's inverse.
+    AffineFrame inverse() const;
+
+    //! Transforms a point by the frame.
+    DirectX::XMFLOAT3 transformPoint(DirectX::XMFLOAT3 const & p) const;
+
+    //! Transforms a direction by the frame (ignoring the translation).
+    DirectX::XMFLOAT3 transformVector(DirectX::XMFLOAT3 const & v) const;
+
+    //! Returns the frame that transforms by @a a and then by @a b.
+    static AffineFrame compose(AffineFrame const & a, AffineFrame const & b);
+
+    //! Returns an untransformed AffineFrame.
+    static AffineFrame identity() { return AffineFrame(); }
+
+private:
+
+    DirectX::XMFLOAT3X4A m_;    //!< The first three columns of the transformation matrix (S * R * T), as rows
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_AFFINEFRAME_H)
@@ -0,0 +1,87 @@
+#pragma once
+
+#if !defined(DXX_BOUNDINGVOLUMEHIERARCHY_H)
+#define DXX_BOUNDINGVOLUMEHIERARCHY_H
+
+#include "Dxx/Culling.h"
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+namespace Dxx
+{
+//! A bounding volume hierarchy of axis-aligned boxes for hierarchical culling of static objects.
+//!
+//! The hierarchy is built using a binned surface area heuristic. The objects are reordered so that the objects in
+//! every subtree are contiguous, so a subtree that is completely inside the culling volume is reported as a single
+//! range of objects without testing any of its nodes. The hierarchy can be refit when the objects move slightly,
+//! which is much cheaper than rebuilding it, though the quality of the hierarchy degrades as the objects move farther.
+//!
+//! @ingroup	Culling
+//!
+
+class BoundingVolumeHierarchy
+{
+public:
+
+    //! A range of entries in objectIndexes().
+    struct Range
+    {
+        uint32_t first;     //!< Index of the first entry
+        uint32_t count;     //!< Number of entries
+    };
+
+    //! Constructor.
+    BoundingVolumeHierarchy() = default;
+
+    //! Builds the hierarchy.
+    void build(BoxBounds const & boxes, int maxLeafSize = 4);
+
+    //! Updates the bounds of the nodes after the objects have moved.
+    void refit(BoxBounds const & boxes);
+
+    //! Appends the ranges of objects that are at least partially inside the culling volume.
+    void cull(CullingFrustum const & frustum, std::vector<Range> & visible, CullStats * pStats = nullptr) const;
+
+    //! Appends the ranges of objects that are at least partially inside the culling volume, using the results of the
+    //! previous call to reduce the number of plane tests.
+    void cullCoherent(CullingFrustum const & frustum, std::vector<Range> & visible, CullStats * pStats = nullptr);
+
+    //! Returns the indexes of the objects in the order that they appear in the hierarchy.
+    uint32_t const * objectIndexes() const { return indexes_.data(); }
+
+    //! Returns the number of objects.
+    size_t objectCount() const { return indexes_.size(); }
+
+    //! Returns the number of nodes.
+    size_t nodeCount() const { return nodes_.size(); }
+
+private:
+
+    // A node. The left child of an interior node immediately follows it, and the parent of a node always precedes it.
+    struct Node
+    {
+        DirectX::XMFLOAT3 min;  // Bounds
+        DirectX::XMFLOAT3 max;
+        uint32_t first;         // Objects in this subtree are indexes_[first] ... indexes_[first + count - 1]
+        uint32_t count;
+        uint32_t right;         // Index of the right child, or 0 if this is a leaf
+    };
+
+    // Builds the subtree containing the objects in the given range and returns the index of its root.
+    uint32_t Build(uint32_t first, uint32_t count);
+
+    // Culls the hierarchy, testing each node's cached plane first if pLastPlanes is not null
+    void Cull(CullingFrustum const & frustum, std::vector<Range> & visible, uint8_t * pLastPlanes, CullStats * pStats) const;
+
+    std::vector<Node> nodes_;                   // Nodes (the root is nodes_[0])
+    std::vector<uint32_t> indexes_;             // Object indexes in the order they appear in the leaves
+    std::vector<uint8_t> lastPlanes_;           // Index of the plane that last rejected each node (for cullCoherent)
+    std::vector<DirectX::XMFLOAT3> boxMin_;     // Object bounds and centroids (only valid during build)
+    std::vector<DirectX::XMFLOAT3> boxMax_;
+    std::vector<DirectX::XMFLOAT3> centroids_;
+    int maxLeafSize_ = 4;                       // Maximum number of objects in a leaf
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_BOUNDINGVOLUMEHIERARCHY_H)
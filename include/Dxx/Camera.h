@@ -17,6 +17,8 @@ namespace Dxx
 
 class Camera
 {
+    friend class CameraBatch;
+
 public:
 
     //! Constructor.
@@ -87,9 +89,21 @@ public:
     //! Sets the view window aspect ratio
     void setAspectRatio(float w, float h);
 
+    //! Returns the view window aspect ratio (w / h).
+    float aspectRatio() const;
+
     //! Sets the view offset
     void setViewOffset(float x, float y);
 
+    //! Returns the view offset.
+    DirectX::XMFLOAT2 viewOffset() const;
+
+    //! Replaces the near clipping plane with an arbitrary plane (an oblique near plane).
+    void setClipPlane(DirectX::XMFLOAT4 const & plane);
+
+    //! Restores the near clipping plane.
+    void clearClipPlane();
+
     //! Rotates the camera.
     void turn(DirectX::XMFLOAT4 const & rotation);
 
@@ -120,32 +134,153 @@ public:
     //! Returns the view frustum
     Frustum viewFrustum() const;
 
+    //! Sequences of sub-pixel offsets applied to the projection for temporal anti-aliasing and upsampling.
+    enum JitterSequence
+    {
+        JITTER_NONE,    //!< No jitter
+        JITTER_HALTON,  //!< Halton sequence with bases 2 and 3
+        JITTER_R2       //!< R2 sequence (additive recurrence based on the plastic number)
+    };
+
+    //! Sets the jitter sequence and the size of the render target in pixels.
+    void setJitter(JitterSequence sequence, float width, float height, int length = 8);
+
+    //! Advances to the next frame.
+    void nextFrame();
+
+    //! Returns the current jitter offset in normalized device coordinates.
+    DirectX::XMFLOAT2 jitter() const;
+
+    //! Returns the change in the jitter offset since the previous frame in normalized device coordinates.
+    DirectX::XMFLOAT2 jitterDelta() const;
+
+    //! Returns the view-projection matrix without the jitter.
+    DirectX::XMFLOAT4X4 unjitteredViewProjectionMatrix() const;
+
+    //! Returns the previous frame's view-projection matrix without the jitter.
+    DirectX::XMFLOAT4X4 previousViewProjectionMatrix() const;
+
+    //! Counts of the number of times each of the derived values has been recomputed.
+    struct Stats
+    {
+        unsigned viewMatrixUpdates;             //!< Number of times the view matrix was recomputed
+        unsigned projectionMatrixUpdates;       //!< Number of times the projection matrix was recomputed
+        unsigned viewProjectionMatrixUpdates;   //!< Number of times the view-projection matrix was recomputed
+        unsigned viewFrustumUpdates;            //!< Number of times the view frustum was recomputed
+    };
+
+    //! Returns the number of times each of the derived values has been recomputed.
+    Stats stats() const { return stats_; }
+
+    //! Resets the recomputation counts.
+    void resetStats() { stats_ = Stats(); }
+
+    class BatchEdit;    // Declared below
+
 protected:
 
+    //! Flags indicating which of the derived values are out of date.
+    enum DirtyFlags
+    {
+        VIEW_MATRIX_DIRTY            = 0x01,    //!< The view matrix must be recomputed
+        PROJECTION_MATRIX_DIRTY      = 0x02,    //!< The projection matrix must be recomputed
+        VIEW_PROJECTION_MATRIX_DIRTY = 0x04,    //!< The view-projection matrix must be recomputed
+        VIEW_FRUSTUM_DIRTY           = 0x08,    //!< The view frustum must be recomputed
+        ALL_DIRTY                    = 0x0f
+    };
+
+    //! Marks the values that depend on the frame of reference as out of date.
+    //!
+    //! If there is a clip plane, the projection matrix depends on the frame of reference too.
+    void InvalidateView()
+    {
+        dirty_ |= VIEW_MATRIX_DIRTY | VIEW_PROJECTION_MATRIX_DIRTY | VIEW_FRUSTUM_DIRTY;
+        if (hasClipPlane_)
+            dirty_ |= PROJECTION_MATRIX_DIRTY;
+    }
+
+    //! Marks the values that depend on the projection parameters as out of date.
+    void InvalidateProjection() { dirty_ |= PROJECTION_MATRIX_DIRTY | VIEW_PROJECTION_MATRIX_DIRTY | VIEW_FRUSTUM_DIRTY; }
+
     //! Syncs the internal state of the camera so that all values are consistent.
     void SyncInternalState();
 
-    Frame frame_;                               //!< View transformation
-    float nearDistance_;                        //!< The distance to the near clipping plane
-    float farDistance_;                         //!< The distance to the far clipping plane
-    float angleOfView_;                         //!< Angle of view of the height of the display (in radians)
-    DirectX::XMFLOAT2 viewOffset_;              //!< View window offset
-    float aspectRatio_;                         //!< View window w / h
-    DirectX::XMFLOAT4X4 viewMatrix_;            //!< The current world-view transformation
-    DirectX::XMFLOAT4X4 projectionMatrix_;      //!< The current projection transformation
-    DirectX::XMFLOAT4X4 viewProjectionMatrix_;  //!< The concatenation of the view matrix and the projection matrix
-    Frustum viewFrustum_;                       //!< View frustum
+    Frame frame_;                                       //!< View transformation
+    float nearDistance_;                                //!< The distance to the near clipping plane
+    float farDistance_;                                 //!< The distance to the far clipping plane
+    float angleOfView_;                                 //!< Angle of view of the height of the display (in radians)
+    DirectX::XMFLOAT2 viewOffset_;                      //!< View window offset
+    float aspectRatio_;                                 //!< View window w / h
+    mutable DirectX::XMFLOAT4X4 viewMatrix_;            //!< The current world-view transformation
+    mutable DirectX::XMFLOAT4X4 projectionMatrix_;      //!< The current projection transformation
+    mutable DirectX::XMFLOAT4X4 viewProjectionMatrix_;  //!< The concatenation of the view matrix and the projection matrix
+    mutable Frustum viewFrustum_;                       //!< View frustum
+    mutable unsigned dirty_;                            //!< Derived values that are out of date (see DirtyFlags)
+    mutable Stats stats_;                               //!< Recomputation counts
+    JitterSequence jitterSequence_;                     //!< Jitter sequence
+    DirectX::XMFLOAT2 jitterScale_;                     //!< Converts a jitter offset in pixels to NDC
+    int jitterLength_;                                  //!< Number of offsets in the jitter sequence before it repeats
+    DirectX::XMFLOAT2 jitter_;                          //!< Current jitter offset (in NDC)
+    DirectX::XMFLOAT2 previousJitter_;                  //!< Previous frame's jitter offset (in NDC)
+    DirectX::XMFLOAT4X4 previousViewProjectionMatrix_;  //!< Previous frame's unjittered view-projection matrix
+    unsigned frameIndex_;                               //!< Number of calls to nextFrame()
+    bool hasClipPlane_;                                 //!< True if the near plane is replaced by clipPlane_
+    DirectX::XMFLOAT4 clipPlane_;                       //!< Oblique near plane (in world space)
 
 private:
 
     // Computes the projection matrix
-    void SyncProjectionMatrix();
+    void SyncProjectionMatrix() const;
 
     // Computes the view matrix
-    void SyncViewMatrix();
+    void SyncViewMatrix() const;
+
+    // Replaces the z column of the projection matrix so that its near plane is the clip plane
+    void ApplyClipPlane() const;
+
+    // Computes the view-projection matrix
+    void SyncViewProjectionMatrix() const;
 
     // Computes the view frustum
-    void ComputeViewFrustum(DirectX::XMFLOAT4X4 const & m);
+    void ComputeViewFrustum(DirectX::XMFLOAT4X4 const & m) const;
+
+    int batchDepth_;    // Number of BatchEdits in progress
+};
+
+//! Defers the synchronization of a camera's derived values while it is being modified.
+//!
+//! The camera's derived values are only recomputed when they are requested, so a sequence of changes costs no
+//! more than a single change. When the outermost BatchEdit goes out of scope, all derived values are brought up to
+//! date so that the camera can then be read (for example, by another thread) without any further recomputation.
+//!
+//! @ingroup	D3dx
+//!
+
+class Camera::BatchEdit
+{
+public:
+
+    //! Constructor.
+    explicit BatchEdit(Camera & camera)
+        : camera_(camera)
+    {
+        ++camera_.batchDepth_;
+    }
+
+    //! Destructor.
+    ~BatchEdit()
+    {
+        if (--camera_.batchDepth_ == 0)
+            camera_.SyncInternalState();
+    }
+
+    // non-copyable
+    BatchEdit(BatchEdit const &) = delete;
+    BatchEdit & operator =(BatchEdit const &) = delete;
+
+private:
+
+    Camera & camera_;
 };
 } // namespace Dxx
 
@@ -166,7 +301,7 @@ namespace Dxx
 inline void Camera::setFrame(Frame const & frame)
 {
     frame_ = frame;
-    SyncInternalState();
+    InvalidateView();
 }
 
 inline Frame Camera::frame() const
@@ -180,7 +315,7 @@ inline Frame Camera::frame() const
 inline void Camera::setPosition(DirectX::XMFLOAT3 const & position)
 {
     frame_.setTranslation(position);
-    SyncInternalState();
+    InvalidateView();
 }
 
 //!
@@ -189,7 +324,7 @@ inline void Camera::setPosition(DirectX::XMFLOAT3 const & position)
 inline void Camera::setOrientation(DirectX::XMFLOAT4 const & orientation)
 {
     frame_.setOrientation(orientation);
-    SyncInternalState();
+    InvalidateView();
 }
 
 //!
@@ -198,7 +333,7 @@ inline void Camera::setOrientation(DirectX::XMFLOAT4 const & orientation)
 inline void Camera::setNearDistance(float nearDistance)
 {
     nearDistance_ = nearDistance;
-    SyncInternalState();
+    InvalidateProjection();
 }
 
 inline float Camera::nearDistance() const
@@ -212,7 +347,7 @@ inline float Camera::nearDistance() const
 inline void Camera::setFarDistance(float farDistance)
 {
     farDistance_ = farDistance;
-    SyncInternalState();
+    InvalidateProjection();
 }
 
 inline float Camera::farDistance() const
@@ -227,7 +362,7 @@ inline float Camera::farDistance() const
 inline void Camera::setAngleOfView(float angle)
 {
     angleOfView_ = MyMath::ToRadians(angle);
-    SyncInternalState();
+    InvalidateProjection();
 }
 
 //! The angle of view is the angle between the top and bottom of the view frustum from the viewpoint.
@@ -244,7 +379,7 @@ inline float Camera::angleOfView() const
 inline void Camera::turn(DirectX::XMFLOAT4 const & rotation)
 {
     frame_.rotate(rotation);
-    SyncInternalState();
+    InvalidateView();
 }
 
 //!
@@ -253,7 +388,7 @@ inline void Camera::turn(DirectX::XMFLOAT4 const & rotation)
 inline void Camera::move(DirectX::XMFLOAT3 const & distance)
 {
     frame_.translate(distance);
-    SyncInternalState();
+    InvalidateView();
 }
 
 //! @param	w	Width of the image on the screen.
@@ -268,7 +403,12 @@ inline void Camera::setAspectRatio(float w, float h)
     assert(h > 0 && w > 0);
 
     aspectRatio_ = w / h;
-    SyncInternalState();
+    InvalidateProjection();
+}
+
+inline float Camera::aspectRatio() const
+{
+    return aspectRatio_;
 }
 
 //! @param	x	X-offset to the center of the near plane in view space.
@@ -277,7 +417,18 @@ inline void Camera::setAspectRatio(float w, float h)
 inline void Camera::setViewOffset(float x, float y)
 {
     viewOffset_ = DirectX::XMFLOAT2(x, y);
-    SyncInternalState();
+    InvalidateProjection();
+}
+
+inline DirectX::XMFLOAT2 Camera::viewOffset() const
+{
+    return viewOffset_;
+}
+
+inline void Camera::clearClipPlane()
+{
+    hasClipPlane_ = false;
+    InvalidateProjection();
 }
 
 inline DirectX::XMFLOAT3 Camera::direction() const
@@ -297,23 +448,46 @@ inline DirectX::XMFLOAT3 Camera::right() const
 
 inline DirectX::XMFLOAT4X4 Camera::projectionMatrix() const
 {
+    if (dirty_ & PROJECTION_MATRIX_DIRTY)
+        SyncProjectionMatrix();
     return projectionMatrix_;
 }
 
 inline DirectX::XMFLOAT4X4 Camera::viewMatrix() const
 {
+    if (dirty_ & VIEW_MATRIX_DIRTY)
+        SyncViewMatrix();
     return viewMatrix_;
 }
 
 inline DirectX::XMFLOAT4X4 Camera::viewProjectionMatrix() const
 {
+    if (dirty_ & VIEW_PROJECTION_MATRIX_DIRTY)
+        SyncViewProjectionMatrix();
     return viewProjectionMatrix_;
 }
 
 inline Frustum Camera::viewFrustum() const
 {
+    if (dirty_ & VIEW_FRUSTUM_DIRTY)
+        ComputeViewFrustum(viewProjectionMatrix());
     return viewFrustum_;
 }
+
+//! The offset is (0, 0) if the jitter sequence is JITTER_NONE.
+
+inline DirectX::XMFLOAT2 Camera::jitter() const
+{
+    return jitter_;
+}
+
+//! Subtract the delta from the difference of the current and previous positions in NDC to get a motion vector that
+//! does not include the jitter.
+
+inline DirectX::XMFLOAT2 Camera::jitterDelta() const
+{
+    return DirectX::XMFLOAT2(jitter_.x - previousJitter_.x, jitter_.y - previousJitter_.y);
+}
 } // namespace Dxx
 
 #endif // !defined(DXX_CAMERA_H)
@@ -0,0 +1,98 @@
+#pragma once
+
+#if !defined(DXX_CAMERABATCH_H)
+#define DXX_CAMERABATCH_H
+
+#include "MyMath/Frustum.h"
+#include <DirectXMath.h>
+#include <vector>
+
+namespace Dxx
+{
+class Camera;
+
+//! A collection of cameras whose derived values are computed together.
+//!
+//! The cameras' parameters are stored in structure-of-arrays form so that the view, projection and view-projection
+//! matrices and the view frustum planes of four cameras are computed at a time using SIMD. The results are the same
+//! as those computed by Camera.
+//!
+//! @ingroup	D3dx
+//!
+
+class CameraBatch
+{
+public:
+
+    //! Constructor.
+    CameraBatch() = default;
+
+    //! Reserves space for the given number of cameras.
+    void reserve(size_t n);
+
+    //! Adds a camera to the batch and returns its index.
+    size_t add(Camera const & camera);
+
+    //! Replaces the values of a camera in the batch.
+    void set(size_t i, Camera const & camera);
+
+    //! Sets a camera's position and orientation.
+    void setFrame(size_t i, DirectX::XMFLOAT3 const & position, DirectX::XMFLOAT4 const & orientation);
+
+    //! Sets a camera's projection parameters.
+    void setProjection(size_t i, float angleOfView, float nearDistance, float farDistance, float aspectRatio);
+
+    //! Sets a camera's view offset.
+    void setViewOffset(size_t i, float x, float y);
+
+    //! Returns the number of cameras in the batch.
+    size_t size() const { return positionX_.size(); }
+
+    //! Removes all cameras from the batch.
+    void clear();
+
+    //! Computes the derived values of all the cameras in the batch.
+    void update();
+
+    //! Returns a camera's view matrix.
+    DirectX::XMFLOAT4X4 const & viewMatrix(size_t i) const { return viewMatrixes_[i]; }
+
+    //! Returns a camera's projection matrix.
+    DirectX::XMFLOAT4X4 const & projectionMatrix(size_t i) const { return projectionMatrixes_[i]; }
+
+    //! Returns a camera's view-projection matrix.
+    DirectX::XMFLOAT4X4 const & viewProjectionMatrix(size_t i) const { return viewProjectionMatrixes_[i]; }
+
+    //! Returns a camera's view frustum.
+    Frustum viewFrustum(size_t i) const;
+
+    //! Copies a camera's values and its derived values from the batch into a camera.
+    void readBack(size_t i, Camera & camera) const;
+
+private:
+
+    // Computes the derived values for the 4 cameras starting at i
+    void update4(size_t i);
+
+    std::vector<float> positionX_;                          // Camera positions
+    std::vector<float> positionY_;
+    std::vector<float> positionZ_;
+    std::vector<float> orientationX_;                       // Camera orientations
+    std::vector<float> orientationY_;
+    std::vector<float> orientationZ_;
+    std::vector<float> orientationW_;
+    std::vector<float> angleOfView_;                        // Angles of view (in radians)
+    std::vector<float> nearDistance_;                       // Distances to the near clipping planes
+    std::vector<float> farDistance_;                        // Distances to the far clipping planes
+    std::vector<float> aspectRatio_;                        // View window w / h
+    std::vector<float> viewOffsetX_;                        // View window offsets
+    std::vector<float> viewOffsetY_;
+
+    std::vector<DirectX::XMFLOAT4X4> viewMatrixes_;           // Computed view matrixes
+    std::vector<DirectX::XMFLOAT4X4> projectionMatrixes_;     // Computed projection matrixes
+    std::vector<DirectX::XMFLOAT4X4> viewProjectionMatrixes_; // Computed view-projection matrixes
+    std::vector<DirectX::XMFLOAT4> frustumPlanes_;            // Computed frustum planes (6 per camera)
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_CAMERABATCH_H)
@@ -0,0 +1,87 @@
+#pragma once
+
+#if !defined(DXX_CAMERACHANNEL_H)
+#define DXX_CAMERACHANNEL_H
+
+#include "Dxx/Frame.h"
+#include "MyMath/Frustum.h"
+#include <atomic>
+#include <cstdint>
+#include <DirectXMath.h>
+
+namespace Dxx
+{
+class Camera;
+
+//! An immutable copy of a camera's values and derived values.
+//!
+//! @ingroup	D3dx
+//!
+
+struct alignas(64) CameraSnapshot
+{
+    DirectX::XMFLOAT4X4 viewMatrix;                     //!< View matrix
+    DirectX::XMFLOAT4X4 projectionMatrix;               //!< Projection matrix
+    DirectX::XMFLOAT4X4 viewProjectionMatrix;           //!< View-projection matrix
+    DirectX::XMFLOAT4X4 previousViewProjectionMatrix;   //!< Previous frame's unjittered view-projection matrix
+    Frustum viewFrustum;                                //!< View frustum
+    Frame frame;                                        //!< Frame of reference
+    float nearDistance;                                 //!< The distance to the near clipping plane
+    float farDistance;                                  //!< The distance to the far clipping plane
+    float angleOfView;                                  //!< Angle of view (in radians)
+    float aspectRatio;                                  //!< View window w / h
+    DirectX::XMFLOAT2 viewOffset;                       //!< View window offset
+    DirectX::XMFLOAT2 jitter;                           //!< Jitter offset (in NDC)
+    DirectX::XMFLOAT2 jitterDelta;                      //!< Jitter offset change since the previous frame (in NDC)
+    uint64_t sequence;                                  //!< Number of snapshots published, including this one
+};
+
+//! Passes snapshots of a camera from one thread to another without locking.
+//!
+//! One thread (such as a simulation thread) publishes snapshots of a camera, and another thread (such as a render
+//! thread) acquires the most recently published snapshot. Neither thread ever blocks or waits for the other, and the
+//! reader never sees a snapshot that is being written.
+//!
+//! The snapshots are triple-buffered: the writer fills its own buffer and then swaps it with the ready buffer, and
+//! the reader swaps its own buffer with the ready buffer if the ready buffer holds a newer snapshot. Each swap is a
+//! single atomic exchange. With only two buffers, the writer would have to wait for the reader to finish with the
+//! older buffer before writing to it.
+//!
+//! Only one thread may publish and only one thread may acquire.
+//!
+//! @ingroup	D3dx
+//!
+
+class CameraChannel
+{
+public:
+
+    //! Constructor.
+    explicit CameraChannel(Camera const & camera);
+
+    // non-copyable
+    CameraChannel(CameraChannel const &) = delete;
+    CameraChannel & operator =(CameraChannel const &) = delete;
+
+    //! Publishes a snapshot of a camera. Called by the writer.
+    void publish(Camera const & camera);
+
+    //! Returns the most recently published snapshot. Called by the reader.
+    CameraSnapshot const & acquire();
+
+private:
+
+    static uint32_t constexpr FRESH = 4;    // Set in ready_ if the ready buffer has not been acquired yet
+
+    // Copies a camera's values into a buffer
+    void Capture(Camera const & camera, uint32_t buffer);
+
+    CameraSnapshot buffers_[3];                     // The snapshots
+    alignas(64) std::atomic<uint32_t> ready_;       // The buffer with the most recent snapshot (plus FRESH)
+    alignas(64) uint32_t writeBuffer_;              // The buffer owned by the writer
+    uint64_t sequence_;                             // Number of snapshots published
+    alignas(64) uint32_t readBuffer_;               // The buffer owned by the reader
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_CAMERACHANNEL_H)
@@ -0,0 +1,53 @@
+#pragma once
+
+#if !defined(DXX_CASCADEDSHADOWMAPS_H)
+#define DXX_CASCADEDSHADOWMAPS_H
+
+#include "Dxx/Culling.h"
+#include <DirectXMath.h>
+
+namespace Dxx
+{
+class Camera;
+class DirectionalLight;
+
+//! One cascade of a cascaded shadow map.
+//!
+//! @ingroup	Culling
+//!
+
+struct ShadowCascade
+{
+    float nearDistance;                     //!< Distance from the camera to the start of the cascade
+    float farDistance;                      //!< Distance from the camera to the end of the cascade
+    DirectX::XMFLOAT4X4 viewProjection;     //!< The light's view-projection matrix for the cascade
+    CullingFrustum frustum;                 //!< The light's view volume for the cascade, for culling shadow casters
+};
+
+//! @name	Cascaded Shadow Maps
+//! @ingroup	Culling
+//!
+//! The camera's view frustum is split by distance into several sub-frusta (cascades), and each cascade gets its own
+//! shadow map, so that nearby shadows get more texels than distant ones.
+//!
+//! The split distances are a blend of a logarithmic distribution, which gives each cascade the same ratio of far
+//! distance to near distance, and a uniform distribution. Logarithmic splits match the way perspective shrinks
+//! distant objects, but they make the near cascades very thin when the near distance is small.
+//@{
+
+//! Computes the distances at which a camera's view frustum is split into cascades.
+void ComputeCascadeSplits(float nearDistance, float farDistance, int count, float lambda, float * pSplits);
+
+//! Computes the cascades of a cascaded shadow map for a camera and a directional light.
+void ComputeShadowCascades(Camera const &           camera,
+                           DirectionalLight const & light,
+                           int                      count,
+                           float                    lambda,
+                           int                      resolution,
+                           float                    casterDistance,
+                           ShadowCascade *          pCascades);
+
+//@}
+} // namespace Dxx
+
+#endif // !defined(DXX_CASCADEDSHADOWMAPS_H)
@@ -0,0 +1,171 @@
+#pragma once
+
+#if !defined(DXX_CULLING_H)
+#define DXX_CULLING_H
+
+#include "MyMath/Frustum.h"
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+//! @defgroup	Culling		Visibility Culling
+//! Functions and classes for determining which objects are visible
+//!
+//! @ingroup	D3dx
+
+namespace Dxx
+{
+//! A convex volume bounded by a set of planes, prepared for testing many bounds at once.
+//!
+//! The planes use the same convention as Camera::viewFrustum(): the normals point out of the volume, so a point
+//! @e p is inside the volume if <tt>dot(plane.xyz, p) + plane.w <= 0</tt> for every plane. The planes are normalized
+//! when they are added, so the plane equation gives the signed distance to the plane.
+//!
+//! @ingroup	Culling
+//!
+
+class CullingFrustum
+{
+public:
+
+    //! Maximum number of planes.
+    static int constexpr MAX_PLANES = 16;
+
+    //! Constructor.
+    CullingFrustum()
+        : count_(0)
+    {
+    }
+
+    //! Constructor.
+    explicit CullingFrustum(Frustum const & frustum);
+
+    //! Constructor.
+    explicit CullingFrustum(DirectX::XMFLOAT4X4 const & viewProjection);
+
+    //! Adds a plane.
+    void add(DirectX::XMFLOAT4 const & plane);
+
+    //! Returns the number of planes.
+    int size() const { return count_; }
+
+    //! Returns a plane.
+    DirectX::XMFLOAT4 const & plane(int i) const { return planes_[i]; }
+
+private:
+
+    DirectX::XMFLOAT4 planes_[MAX_PLANES];  // The planes
+    int count_;                             // Number of planes
+};
+
+//! Bounding spheres in structure-of-arrays form.
+//!
+//! @ingroup	Culling
+
+struct SphereBounds
+{
+    float const * x;        //!< Centers
+    float const * y;        //!< Centers
+    float const * z;        //!< Centers
+    float const * radius;   //!< Radii
+    size_t count;           //!< Number of spheres
+};
+
+//! Axis-aligned bounding boxes in structure-of-arrays form.
+//!
+//! @ingroup	Culling
+
+struct BoxBounds
+{
+    float const * minX;     //!< Minimum corners
+    float const * minY;     //!< Minimum corners
+    float const * minZ;     //!< Minimum corners
+    float const * maxX;     //!< Maximum corners
+    float const * maxY;     //!< Maximum corners
+    float const * maxZ;     //!< Maximum corners
+    size_t count;           //!< Number of boxes
+};
+
+//! Counts of the work done by a culling operation.
+//!
+//! @ingroup	Culling
+
+struct CullStats
+{
+    uint64_t boundsTested;  //!< Number of bounding volumes tested
+    uint64_t planeTests;    //!< Number of bounding volume vs. plane tests
+};
+
+//! @name	Culling Functions
+//! @ingroup	Culling
+//@{
+
+//! Classification of a bounding volume with respect to a culling volume.
+enum CullResult
+{
+    CULL_OUTSIDE      = 0,  //!< Completely outside
+    CULL_INTERSECTING = 1,  //!< Partially inside
+    CULL_INSIDE       = 2   //!< Completely inside
+};
+
+//! Returns the number of 32-bit words in a visibility bitset for the given number of objects.
+inline size_t VisibilityBitsetSize(size_t count) { return (count + 31) / 32; }
+
+//! Classifies bounding spheres against a culling volume.
+void ClassifySpheres(CullingFrustum const & frustum, SphereBounds const & spheres, uint8_t * pResults);
+
+//! Classifies bounding boxes against a culling volume.
+void ClassifyBoxes(CullingFrustum const & frustum, BoxBounds const & boxes, uint8_t * pResults);
+
+//! Determines which bounding spheres are at least partially inside a culling volume.
+void CullSpheres(CullingFrustum const & frustum, SphereBounds const & spheres, uint32_t * pVisible);
+
+//! Determines which bounding boxes are at least partially inside a culling volume.
+void CullBoxes(CullingFrustum const & frustum, BoxBounds const & boxes, uint32_t * pVisible);
+
+//! Converts a visibility bitset into a list of the indexes of the visible objects. Returns the number of indexes.
+size_t CompactVisible(uint32_t const * pVisible, size_t count, uint32_t * pIndexes);
+
+//@}
+
+//! Culls objects using the results of the previous frame to reduce the number of plane tests.
+//!
+//! The culling volume usually changes very little from one frame to the next, so an object that was rejected by a
+//! plane in the previous frame is usually rejected by the same plane again. The index of the plane that last rejected
+//! each object is saved, and that plane is tested first.
+//!
+//! The objects must be the same (and in the same order) from one frame to the next. Otherwise, reset() must be called.
+//!
+//! @ingroup	Culling
+//!
+
+class CoherentCuller
+{
+public:
+
+    //! Constructor.
+    CoherentCuller() = default;
+
+    //! Forgets the results of the previous frame.
+    void reset() { lastPlanes_.clear(); }
+
+    //! Determines which bounding spheres are at least partially inside a culling volume.
+    void cullSpheres(CullingFrustum const & frustum, SphereBounds const & spheres, uint32_t * pVisible);
+
+    //! Determines which bounding boxes are at least partially inside a culling volume.
+    void cullBoxes(CullingFrustum const & frustum, BoxBounds const & boxes, uint32_t * pVisible);
+
+    //! Returns the counts of the work done by the last call to cullSpheres() or cullBoxes().
+    CullStats stats() const { return stats_; }
+
+private:
+
+    // Prepares the plane cache for the given number of objects
+    void Prepare(size_t count);
+
+    std::vector<uint8_t> lastPlanes_;   // Index of the plane that last rejected each object (or NO_PLANE)
+    CullStats stats_ = CullStats();     // Counts of the work done by the last cull
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_CULLING_H)
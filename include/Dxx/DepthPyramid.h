@@ -0,0 +1,73 @@
+#pragma once
+
+#if !defined(DXX_DEPTHPYRAMID_H)
+#define DXX_DEPTHPYRAMID_H
+
+#include "Dxx/Culling.h"
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+namespace Dxx
+{
+class Camera;
+
+//! A hierarchical-Z pyramid for conservative occlusion tests.
+//!
+//! Level 0 is a copy of a depth buffer (z / w, with row 0 at the top of the screen), such as the one produced by
+//! OcclusionBuffer or read back from the previous frame. Each texel in the next level is the farthest depth of the
+//! 2x2 texels below it. A box is tested by projecting it onto the screen and choosing the level at which its
+//! rectangle spans at most 2x2 texels, so each test reads at most 4 texels no matter how large the box is.
+//!
+//! The test is conservative: a box is only reported as occluded if its nearest depth is behind the farthest depth
+//! of every texel that it overlaps.
+//!
+//! @ingroup	Culling
+//!
+
+class DepthPyramid
+{
+public:
+
+    //! Constructor.
+    DepthPyramid() = default;
+
+    //! Builds the pyramid from a depth buffer.
+    void build(float const * pDepth, int width, int height);
+
+    //! Determines which boxes are occluded.
+    void testBoxes(Camera const & camera, BoxBounds const & boxes, uint32_t * pVisible) const;
+
+    //! Determines which boxes are occluded.
+    void testBoxes(DirectX::XMFLOAT4X4 const & viewProjection, BoxBounds const & boxes, uint32_t * pVisible) const;
+
+    //! Returns the number of levels.
+    int levelCount() const { return int(levels_.size()); }
+
+    //! Returns the width of a level in texels.
+    int width(int level) const { return levels_[level].width; }
+
+    //! Returns the height of a level in texels.
+    int height(int level) const { return levels_[level].height; }
+
+    //! Returns the depths in a level.
+    float const * depth(int level) const { return levels_[level].depth.data(); }
+
+private:
+
+    // A level in the pyramid
+    struct Level
+    {
+        int width;
+        int height;
+        std::vector<float> depth;
+    };
+
+    // Returns true if any part of the box is possibly visible
+    bool IsVisible(DirectX::FXMMATRIX viewProjection, DirectX::XMFLOAT3 const & min, DirectX::XMFLOAT3 const & max) const;
+
+    std::vector<Level> levels_; // Levels (levels_[0] is full resolution)
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_DEPTHPYRAMID_H)
@@ -3,11 +3,31 @@
 
 #pragma once
 
+#include "Dxx/AffineFrame.h"
+#include "Dxx/BoundingVolumeHierarchy.h"
 #include "Dxx/Camera.h"
+#include "Dxx/CameraBatch.h"
+#include "Dxx/CameraChannel.h"
+#include "Dxx/CascadedShadowMaps.h"
+#include "Dxx/Culling.h"
 #include "Dxx/D3dx.h"
+#include "Dxx/DepthPyramid.h"
 #include "Dxx/Frame.h"
+#include "Dxx/InstanceCompactor.h"
 #include "Dxx/Light.h"
+#include "Dxx/LodSelector.h"
+#include "Dxx/LooseOctree.h"
+#include "Dxx/MultiViewCuller.h"
+#include "Dxx/NormalConeClusters.h"
+#include "Dxx/OcclusionBuffer.h"
+#include "Dxx/PortalGraph.h"
+#include "Dxx/PotentiallyVisibleSet.h"
+#include "Dxx/PrimaryRays.h"
 #include "Dxx/Random.h"
+#include "Dxx/ShadowCasterVolume.h"
+#include "Dxx/SpatialHashGrid.h"
+#include "Dxx/TransformHierarchy.h"
+#include "Dxx/TransformStreams.h"
 #include "Dxx/VertexBuffer.h"
 #include "Dxx/VertexBufferLock.h"
 #include "Dxx/VertexBufferProxy.h"
@@ -10,6 +10,9 @@ namespace Dxx
 {
 //! A frame of reference including translation, scale, and orientation.
 //!
+//! The translation, orientation, and scale are stored along with the transformation matrix (M = S * R * T), so
+//! getting or setting one of them does not require decomposing the matrix.
+//!
 //! @ingroup	D3dx
 //!
 
@@ -19,7 +22,10 @@ public:
 
     //! Constructor.
     constexpr Frame()
-        : m_(DirectX::XMFLOAT4X4(
+        : t_(0.0f, 0.0f, 0.0f)
+        , r_(0.0f, 0.0f, 0.0f, 1.0f)
+        , s_(1.0f, 1.0f, 1.0f)
+        , m_(DirectX::XMFLOAT4X4(
                  1.0f, 0.0f, 0.0f, 0.0f,
                  0.0f, 1.0f, 0.0f, 0.0f,
                  0.0f, 0.0f, 1.0f, 0.0f,
@@ -45,7 +51,7 @@ public:
     void setTranslation(DirectX::XMFLOAT3 const & t);
 
     //! Returns the frame's translation.
-    DirectX::XMFLOAT3 translation() const;
+    DirectX::XMFLOAT3 translation() const { return t_; }
 
     //! Sets the frame's rotation according to the given quaternion.
     void setOrientation(DirectX::XMFLOAT4 const & r);
@@ -54,7 +60,7 @@ public:
     void setOrientation(DirectX::XMFLOAT3X3 const & r);
 
     //! Returns the frame's rotation as a quaternion.
-    DirectX::XMFLOAT4 orientation() const;
+    DirectX::XMFLOAT4 orientation() const { return r_; }
 
     //! Returns the frame's orientation as a matrix.
     DirectX::XMFLOAT3X3 orientationMatrix() const;
@@ -63,13 +69,13 @@ public:
     void setScale(DirectX::XMFLOAT3 const & s);
 
     //! Returns the frame's scale.
-    DirectX::XMFLOAT3 scale() const;
+    DirectX::XMFLOAT3 scale() const { return s_; }
 
     //! Sets the frame's transformation matrix.
     void setTransformation(DirectX::XMFLOAT4X4 const & m);
 
     //! Returns the frame's transformation matrix.
-    DirectX::XMFLOAT4X4 transformation() const;
+    DirectX::XMFLOAT4X4 transformation() const { return m_; }
 
     //! Returns the frame's unit X axis in global space.
     DirectX::XMFLOAT3 xAxis() const;
@@ -85,7 +91,16 @@ public:
 
 private:
 
-    DirectX::XMFLOAT4X4 m_;  //!< Transformation matrix
+    // Computes the transformation matrix from the translation, orientation, and scale
+    void Compose();
+
+    // Computes the translation, orientation, and scale from the transformation matrix
+    void Decompose();
+
+    DirectX::XMFLOAT3 t_;       //!< Translation
+    DirectX::XMFLOAT4 r_;       //!< Orientation (a unit quaternion)
+    DirectX::XMFLOAT3 s_;       //!< Scale
+    DirectX::XMFLOAT4X4 m_;     //!< Transformation matrix (S * R * T)
 };
 } // namespace Dxx
 
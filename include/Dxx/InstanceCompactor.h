@@ -0,0 +1,49 @@
+#pragma once
+
+#if !defined(DXX_INSTANCECOMPACTOR_H)
+#define DXX_INSTANCECOMPACTOR_H
+
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+namespace Dxx
+{
+class Frame;
+
+//! Packs the transformations of the visible objects into an instance buffer, grouped by mesh.
+//!
+//! Each instance is the transpose of the upper 3 columns of the object's transformation matrix (the 4th column of a
+//! Frame's transformation is always (0, 0, 0, 1)), which is the layout of XMFLOAT3X4 and of a float3x4 in HLSL. An
+//! instance is 48 bytes instead of 64.
+//!
+//! The instances of each mesh are contiguous and in the same order as the objects. They are written with streaming
+//! stores, which bypass the cache, so the output can be written directly to a mapped dynamic buffer or a staging
+//! array for CreateStaticVertexBuffer() without evicting the data being culled.
+//!
+//! The objects are processed in parallel. The instance keeps scratch memory between calls, so an instance should be
+//! reused from frame to frame.
+//!
+//! @ingroup	Culling
+//!
+
+class InstanceCompactor
+{
+public:
+
+    //! Writes the instances of the visible objects and returns the number written.
+    size_t compact(uint32_t const *       pVisible,
+                   Frame const *          pFrames,
+                   uint32_t const *       pMeshIds,
+                   size_t                 count,
+                   uint32_t               meshCount,
+                   DirectX::XMFLOAT3X4A * pInstances,
+                   uint32_t *             pOffsets);
+
+private:
+
+    std::vector<uint32_t> counts_;  // Number of visible objects of each mesh in each chunk, then the chunk's offsets
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_INSTANCECOMPACTOR_H)
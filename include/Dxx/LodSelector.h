@@ -0,0 +1,65 @@
+#pragma once
+
+#if !defined(DXX_LODSELECTOR_H)
+#define DXX_LODSELECTOR_H
+
+#include "Dxx/Culling.h"
+#include <cstdint>
+#include <DirectXMath.h>
+
+namespace Dxx
+{
+class Camera;
+
+//! Selects levels of detail by the projected size of objects on the screen.
+//!
+//! The size of an object is the radius of its bounding sphere projected onto the screen, in pixels. Since it is
+//! computed from the projection matrix, it takes the camera's angle of view into account, so zooming in selects finer
+//! levels of detail.
+//!
+//! Each object has its own thresholds, in pixels and in decreasing order. Level 0 is used if the size is at least the
+//! first threshold, level 1 if the size is at least the second threshold, and so on. To keep objects from switching
+//! back and forth when their sizes are near a threshold, an object does not change its level until its size moves
+//! past the threshold by a fraction of the threshold (the hysteresis). Objects smaller than a minimum size are culled.
+//!
+//! Objects are processed 4 at a time.
+//!
+//! @ingroup	Culling
+//!
+
+class LodSelector
+{
+public:
+
+    //! Constructor.
+    LodSelector(Camera const & camera, float viewportHeight);
+
+    //! Constructor.
+    LodSelector(DirectX::XMFLOAT4X4 const & projection, DirectX::XMFLOAT3 const & eye, float viewportHeight);
+
+    //! Sets the hysteresis, as a fraction of each threshold. The default is 0.1.
+    void setHysteresis(float hysteresis) { hysteresis_ = hysteresis; }
+
+    //! Sets the minimum size in pixels. Objects that are smaller are culled. The default is 0.
+    void setMinimumSize(float pixels) { minimumSize_ = pixels; }
+
+    //! Computes the projected size of each object in pixels.
+    void computeSizes(SphereBounds const & spheres, float * pSizes) const;
+
+    //! Selects the level of detail of each object and culls the objects that are too small.
+    void select(SphereBounds const & spheres,
+                float const *        pThresholds,
+                int                  thresholdCount,
+                uint8_t *            pLods,
+                uint32_t *           pVisible) const;
+
+private:
+
+    DirectX::XMFLOAT3 eye_;     // Position of the camera
+    float scale_;               // Converts radius / distance to pixels
+    float hysteresis_;          // Fraction of a threshold that a size must pass it by to change levels
+    float minimumSize_;         // Objects smaller than this (in pixels) are culled
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_LODSELECTOR_H)
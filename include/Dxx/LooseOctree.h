@@ -0,0 +1,125 @@
+#pragma once
+
+#if !defined(DXX_LOOSEOCTREE_H)
+#define DXX_LOOSEOCTREE_H
+
+#include "Dxx/Culling.h"
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+namespace Dxx
+{
+class Frame;
+
+//! A loose octree of bounding spheres, for culling objects that move.
+//!
+//! The bounds of each node are twice the size of its cell, so an object fits in a node if its center is in the node's
+//! cell and its radius is no larger than half the size of the cell. An object is placed in the deepest node that it
+//! fits in, based on its position and radius alone. Since the bounds of neighboring nodes overlap, a moving object does
+//! not need to be moved to another node until it leaves the bounds of its node, so most updates only store the new
+//! position.
+//!
+//! The nodes and objects are kept in pools, and the objects in each node are linked together, so inserting, updating,
+//! and removing objects do not allocate memory except when a pool grows.
+//!
+//! Objects that are outside of the root's cell or too large for any other node are kept in the root.
+//!
+//! @ingroup	Culling
+//!
+
+class LooseOctree
+{
+public:
+
+    //! Constructor.
+    LooseOctree(DirectX::XMFLOAT3 const & center, float halfSize, int maxDepth = 8);
+
+    //! Inserts an object and returns its id.
+    uint32_t insert(Frame const & frame, float radius);
+
+    //! Inserts an object and returns its id.
+    uint32_t insert(DirectX::XMFLOAT3 const & position, float radius);
+
+    //! Updates the position and radius of an object.
+    void update(uint32_t id, Frame const & frame, float radius);
+
+    //! Updates the position and radius of an object.
+    void update(uint32_t id, DirectX::XMFLOAT3 const & position, float radius);
+
+    //! Removes an object.
+    void remove(uint32_t id);
+
+    //! Appends the ids of the objects that are at least partially inside a view frustum.
+    void cull(Frustum const & frustum, std::vector<uint32_t> & visible) const;
+
+    //! Appends the ids of the objects that are at least partially inside a culling volume.
+    void cull(CullingFrustum const & frustum, std::vector<uint32_t> & visible) const;
+
+    //! Returns the number of objects.
+    size_t objectCount() const { return objectCount_; }
+
+    //! Returns the number of nodes.
+    size_t nodeCount() const { return nodeCount_; }
+
+    //! Returns the number of times that an object has been moved to another node by update().
+    size_t relinkCount() const { return relinkCount_; }
+
+private:
+
+    static uint32_t constexpr NONE = ~0u;   // Indicates no node or object
+
+    // A node. A free node's parent is the next free node.
+    struct Node
+    {
+        DirectX::XMFLOAT3 center;   // Center of the cell
+        float halfSize;             // Half the size of the cell (the bounds are twice the size)
+        uint32_t parent;            // Parent node
+        uint32_t children[8];       // Child nodes (indexed by octant)
+        uint32_t childCount;        // Number of children
+        uint32_t firstObject;       // The first object in the list of objects in this node
+    };
+
+    // An object. A free object's next is the next free object.
+    struct Object
+    {
+        DirectX::XMFLOAT3 position; // Center of the bounding sphere
+        float radius;               // Radius of the bounding sphere
+        uint32_t node;              // The node containing the object, or NONE if the object is free
+        uint32_t previous;          // Links in the list of objects in the node
+        uint32_t next;
+    };
+
+    // Returns the node that an object with the given bounds belongs in, creating nodes as necessary
+    uint32_t Find(DirectX::XMFLOAT3 const & position, float radius);
+
+    // Returns true if the object with the given bounds is inside the bounds of the node
+    bool Fits(uint32_t node, DirectX::XMFLOAT3 const & position, float radius) const;
+
+    // Adds an object to the list of objects in a node
+    void Link(uint32_t id, uint32_t node);
+
+    // Removes an object from the list of objects in its node
+    void Unlink(uint32_t id);
+
+    // Returns a node and any of its ancestors that are left empty to the pool
+    void Prune(uint32_t node);
+
+    // Returns a node from the pool
+    uint32_t AllocateNode(DirectX::XMFLOAT3 const & center, float halfSize, uint32_t parent);
+
+    // Appends the ids of all of the objects in a subtree
+    void AppendSubtree(uint32_t node, std::vector<uint32_t> & visible) const;
+
+    std::vector<Node> nodes_;       // Node pool (the root is nodes_[0])
+    std::vector<Object> objects_;   // Object pool (an object's id is its index)
+    uint32_t freeNodes_;            // The first free node
+    uint32_t freeObjects_;          // The first free object
+    size_t nodeCount_;              // Number of nodes in use
+    size_t objectCount_;            // Number of objects in use
+    size_t relinkCount_;            // Number of times that an object has been moved to another node
+    int maxDepth_;                  // Maximum depth of a node
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_LOOSEOCTREE_H)
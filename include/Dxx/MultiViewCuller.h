@@ -0,0 +1,74 @@
+#pragma once
+
+#if !defined(DXX_MULTIVIEWCULLER_H)
+#define DXX_MULTIVIEWCULLER_H
+
+#include "Dxx/Culling.h"
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+namespace Dxx
+{
+class Camera;
+
+//! Culls objects against several views at once.
+//!
+//! When a scene is rendered from several views (such as the faces of a cube map, the eyes of a stereo pair, or the
+//! cascades of a shadow map), culling each view separately loads and tests every object once per view. Instead, the
+//! views are culled together and each object's bounds are loaded once. The result for each object is a mask with one
+//! bit per view.
+//!
+//! Planes that are shared by more than one view (such as the planes between adjacent faces of a cube map, which are
+//! the same plane facing opposite directions) are only tested once.
+//!
+//! @ingroup	Culling
+//!
+
+class MultiViewCuller
+{
+public:
+
+    //! Maximum number of views.
+    static int constexpr MAX_VIEWS = 8;
+
+    //! Constructor.
+    MultiViewCuller() = default;
+
+    //! Adds a view and returns its index, which is the index of its bit in the masks.
+    int addView(CullingFrustum const & frustum);
+
+    //! Adds a camera's view and returns its index, which is the index of its bit in the masks.
+    int addView(Camera const & camera);
+
+    //! Removes all of the views.
+    void clear();
+
+    //! Determines which views each bounding sphere is at least partially inside of.
+    void cullSpheres(SphereBounds const & spheres, uint8_t * pMasks) const;
+
+    //! Determines which views each bounding box is at least partially inside of.
+    void cullBoxes(BoxBounds const & boxes, uint8_t * pMasks) const;
+
+    //! Returns the number of views.
+    int viewCount() const { return viewCount_; }
+
+    //! Returns the number of distinct planes.
+    int planeCount() const { return int(planes_.size()); }
+
+private:
+
+    // A plane and the views that it bounds
+    struct SharedPlane
+    {
+        DirectX::XMFLOAT4 plane;    // The plane
+        uint8_t views;              // The views that are bounded by the plane
+        uint8_t oppositeViews;      // The views that are bounded by the plane facing the opposite direction
+    };
+
+    std::vector<SharedPlane> planes_;   // Distinct planes
+    int viewCount_ = 0;                 // Number of views
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_MULTIVIEWCULLER_H)
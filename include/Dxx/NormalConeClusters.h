@@ -0,0 +1,76 @@
+#pragma once
+
+#if !defined(DXX_NORMALCONECLUSTERS_H)
+#define DXX_NORMALCONECLUSTERS_H
+
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+namespace Dxx
+{
+class Camera;
+
+//! Clusters of triangles with bounding normal cones, for culling clusters that are completely back-facing.
+//!
+//! The triangles of a mesh are divided into clusters of consecutive triangles. The face normals of the triangles in a
+//! cluster (as computed by ComputeFaceNormal()) are bounded by a cone, and the positions are bounded by a sphere. If
+//! every direction in the cone faces away from every point in the sphere, then every triangle in the cluster is
+//! back-facing and the cluster does not need to be drawn.
+//!
+//! The test is conservative, and clusters whose normals spread over 90 degrees or more are never culled. The triangles
+//! should be ordered so that neighboring triangles are close together in the index buffer.
+//!
+//! @ingroup	Culling
+//!
+
+class NormalConeClusters
+{
+public:
+
+    //! A range of indexes.
+    struct Cluster
+    {
+        uint32_t firstIndex;    //!< The first index in the index buffer
+        uint32_t indexCount;    //!< Number of indexes
+    };
+
+    //! Constructor.
+    NormalConeClusters() = default;
+
+    //! Builds the clusters of a triangle list.
+    void build(DirectX::XMFLOAT3 const * pVertices,
+               uint32_t const *          pIndexes,
+               size_t                    indexCount,
+               int                       maxTriangles = 64);
+
+    //! Clears the bits of the clusters that are back-facing when viewed from a position (in the mesh's space).
+    void cullBackfacing(DirectX::XMFLOAT3 const & eye, uint32_t * pVisible) const;
+
+    //! Clears the bits of the clusters that are back-facing when viewed by a camera.
+    void cullBackfacing(Camera const & camera, DirectX::XMFLOAT4X4 const & world, uint32_t * pVisible) const;
+
+    //! Returns the number of clusters.
+    size_t clusterCount() const { return clusters_.size(); }
+
+    //! Returns a cluster.
+    Cluster const & cluster(size_t i) const { return clusters_[i]; }
+
+private:
+
+    std::vector<Cluster> clusters_;     // Index ranges
+
+    // Bounding spheres and normal cones in structure-of-arrays form
+    std::vector<float> x_;
+    std::vector<float> y_;
+    std::vector<float> z_;
+    std::vector<float> radius_;
+    std::vector<float> axisX_;
+    std::vector<float> axisY_;
+    std::vector<float> axisZ_;
+    std::vector<float> cosAngle_;       // Cosine of the angle between the axis and the side of the cone
+    std::vector<float> sinAngle_;       // Sine of the angle between the axis and the side of the cone
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_NORMALCONECLUSTERS_H)
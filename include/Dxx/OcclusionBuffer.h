@@ -0,0 +1,99 @@
+#pragma once
+
+#if !defined(DXX_OCCLUSIONBUFFER_H)
+#define DXX_OCCLUSIONBUFFER_H
+
+#include "Dxx/Culling.h"
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+namespace Dxx
+{
+class Camera;
+
+//! A low-resolution depth buffer rendered on the CPU for occlusion culling.
+//!
+//! Occluder meshes are transformed by the camera's view-projection matrix, binned into screen tiles, and then the
+//! tiles are rasterized in parallel, 4 pixels at a time. Occludees are tested against the buffer using the screen
+//! rectangle and the nearest depth of their bounding boxes.
+//!
+//! Usage:
+//!		- begin()
+//!		- addOccluder() for each occluder
+//!		- rasterize()
+//!		- testBoxes()
+//!
+//! The test is conservative. Occluder triangles that cross the near plane are skipped, and only the pixels whose
+//! centers are inside an occluder triangle are covered.
+//!
+//! @ingroup	Culling
+//!
+
+class OcclusionBuffer
+{
+public:
+
+    static int constexpr TILE_WIDTH  = 32;  //!< Width of a tile in pixels
+    static int constexpr TILE_HEIGHT = 16;  //!< Height of a tile in pixels
+
+    //! Constructor.
+    OcclusionBuffer(int width, int height);
+
+    //! Clears the buffer and starts a new frame.
+    void begin(Camera const & camera);
+
+    //! Clears the buffer and starts a new frame.
+    void begin(DirectX::XMFLOAT4X4 const & viewProjection);
+
+    //! Adds an occluder mesh.
+    void addOccluder(DirectX::XMFLOAT3 const *   pVertices,
+                     size_t                      vertexCount,
+                     uint32_t const *            pIndexes,
+                     size_t                      indexCount,
+                     DirectX::XMFLOAT4X4 const & world);
+
+    //! Rasterizes the occluders.
+    void rasterize();
+
+    //! Determines which boxes are occluded.
+    void testBoxes(BoxBounds const & boxes, uint32_t * pVisible) const;
+
+    //! Returns the width of the buffer in pixels.
+    int width() const { return width_; }
+
+    //! Returns the height of the buffer in pixels.
+    int height() const { return height_; }
+
+    //! Returns the depth buffer (z / w of the nearest occluder at each pixel, or 1 if there is none).
+    float const * depth() const { return depth_.data(); }
+
+private:
+
+    // A triangle in screen space
+    struct Triangle
+    {
+        float x[3];
+        float y[3];
+        float z[3];
+    };
+
+    // Rasterizes the triangles in a tile
+    void RasterizeTile(int tile);
+
+    // Returns true if any part of the box is possibly visible
+    bool IsVisible(DirectX::FXMMATRIX viewProjection, DirectX::XMFLOAT3 const & min, DirectX::XMFLOAT3 const & max) const;
+
+    int width_;                                 // Width in pixels
+    int height_;                                // Height in pixels
+    int tilesX_;                                // Number of tiles across
+    int tilesY_;                                // Number of tiles down
+    DirectX::XMFLOAT4X4 viewProjection_;        // View-projection matrix for the current frame
+    std::vector<float> depth_;                  // Depth buffer
+    std::vector<Triangle> triangles_;           // Occluder triangles for the current frame
+    std::vector<std::vector<uint32_t> > bins_;  // Indexes of the triangles overlapping each tile
+    std::vector<DirectX::XMFLOAT4> clip_;       // Scratch space for transformed vertexes
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_OCCLUSIONBUFFER_H)
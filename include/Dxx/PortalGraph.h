@@ -0,0 +1,92 @@
+#pragma once
+
+#if !defined(DXX_PORTALGRAPH_H)
+#define DXX_PORTALGRAPH_H
+
+#include "Dxx/Culling.h"
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+namespace Dxx
+{
+class Camera;
+
+//! A graph of cells connected by portals, for visibility determination in indoor environments.
+//!
+//! A cell is a region of space (such as a room or a corridor) and a portal is a convex polygon (such as a doorway or
+//! a window) through which one cell can be seen from another. Starting at the camera's cell, the view frustum is
+//! narrowed to each portal that it can see, and the cell on the other side is visited with the narrowed frustum. Only
+//! the cells that are reached are visible, and the objects in each visible cell only need to be tested against the
+//! frustum that the cell was reached with.
+//!
+//! The narrowed frustums are CullingFrustums, so they can be used directly with CullBoxes(), CullSpheres(), etc.
+//!
+//! @ingroup	Culling
+//!
+
+class PortalGraph
+{
+public:
+
+    //! Maximum number of vertexes in a portal.
+    static int constexpr MAX_PORTAL_VERTICES = 8;
+
+    //! A cell reached by findVisibleCells().
+    struct VisibleCell
+    {
+        int cell;                   //!< Index of the cell
+        CullingFrustum frustum;     //!< The view frustum narrowed to the portals that the cell is seen through
+    };
+
+    //! Constructor.
+    PortalGraph() = default;
+
+    //! Adds a cell and returns its index.
+    int addCell();
+
+    //! Adds a portal between two cells and returns its index.
+    int addPortal(int cellA, int cellB, DirectX::XMFLOAT3 const * pVertices, int vertexCount);
+
+    //! Determines which cells are visible from a camera.
+    void findVisibleCells(Camera const & camera, int cell, std::vector<VisibleCell> & visible) const;
+
+    //! Returns the number of cells.
+    int cellCount() const { return int(cells_.size()); }
+
+    //! Returns the number of portals.
+    int portalCount() const { return int(portals_.size()); }
+
+private:
+
+    // A portal
+    struct Portal
+    {
+        int cells[2];           // The cells on either side
+        uint32_t firstVertex;   // The polygon is vertices_[firstVertex] ... vertices_[firstVertex + vertexCount - 1]
+        int vertexCount;
+        DirectX::XMFLOAT4 plane;
+    };
+
+    // Visits a cell and the cells that can be seen through its portals
+    void Visit(int                          cell,
+               CullingFrustum const &       frustum,
+               DirectX::XMFLOAT3 const &    eye,
+               DirectX::XMFLOAT4 const &    farPlane,
+               std::vector<uint8_t> &       onPath,
+               std::vector<VisibleCell> &   visible) const;
+
+    // Narrows a frustum to a portal. Returns false if the portal is not visible.
+    bool Narrow(Portal const &              portal,
+                CullingFrustum const &      frustum,
+                DirectX::XMFLOAT3 const &   eye,
+                DirectX::XMFLOAT4 const &   farPlane,
+                CullingFrustum *            pNarrowed) const;
+
+    std::vector<std::vector<int> > cells_;      // Indexes of the portals of each cell
+    std::vector<Portal> portals_;               // Portals
+    std::vector<DirectX::XMFLOAT3> vertices_;   // Portal polygon vertexes
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_PORTALGRAPH_H)
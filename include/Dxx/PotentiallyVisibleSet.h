@@ -0,0 +1,102 @@
+#pragma once
+
+#if !defined(DXX_POTENTIALLYVISIBLESET_H)
+#define DXX_POTENTIALLYVISIBLESET_H
+
+#include "Dxx/Culling.h"
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+namespace Dxx
+{
+//! A precomputed potentially visible set (PVS) of static objects.
+//!
+//! The world is divided into a grid of view cells. When the set is baked, the view from a number of positions in each
+//! cell is rendered in all directions into an OcclusionBuffer, and every object that is visible from any of the
+//! positions is recorded. At run time, the objects that are potentially visible from a position are found by looking
+//! up the cell containing the position, without doing any occlusion tests.
+//!
+//! The visibility of each cell is stored as a run-length encoded bitset. Runs of words that are all 0 or all 1 are
+//! stored as a single token, and other words are stored as is.
+//!
+//! @note	Since the visibility is sampled, an object that is only visible through a small gap from a small part of a
+//!			cell may be missed. The sample positions should not be inside of any occluders.
+//!
+//! @ingroup	Culling
+//!
+
+class PotentiallyVisibleSet
+{
+public:
+
+    //! The view cells.
+    struct Grid
+    {
+        DirectX::XMFLOAT3 origin;   //!< Minimum corner of the grid
+        DirectX::XMFLOAT3 cellSize; //!< Size of each cell
+        int cellsX;                 //!< Number of cells along the X axis
+        int cellsY;                 //!< Number of cells along the Y axis
+        int cellsZ;                 //!< Number of cells along the Z axis
+    };
+
+    //! An occluder mesh.
+    struct Occluder
+    {
+        DirectX::XMFLOAT3 const * pVertices;    //!< Vertex positions
+        size_t vertexCount;                     //!< Number of vertexes
+        uint32_t const * pIndexes;              //!< Triangle list indexes
+        size_t indexCount;                      //!< Number of indexes
+        DirectX::XMFLOAT4X4 world;              //!< World transformation
+    };
+
+    //! Parameters for baking.
+    struct BakeSettings
+    {
+        int samplesPerAxis = 2;         //!< The number of sample positions in each cell is the cube of this value
+        int resolution     = 128;       //!< Width and height of the occlusion buffer (must be a multiple of 4)
+        float nearDistance = 0.1f;      //!< Near distance of the sample cameras
+        float farDistance  = 1000.0f;   //!< Far distance of the sample cameras
+    };
+
+    //! Constructor.
+    PotentiallyVisibleSet() = default;
+
+    //! Bakes the set.
+    void bake(Grid const &         grid,
+              BoxBounds const &    objects,
+              Occluder const *     pOccluders,
+              size_t               occluderCount,
+              BakeSettings const & settings);
+
+    //! Returns the index of the cell containing a position, or -1 if the position is not in the grid.
+    int findCell(DirectX::XMFLOAT3 const & position) const;
+
+    //! Stores the objects that are potentially visible from a cell in a visibility bitset.
+    void getVisible(int cell, uint32_t * pVisible) const;
+
+    //! Clears the bits of the objects that are not potentially visible from a cell.
+    void filterVisible(int cell, uint32_t * pVisible) const;
+
+    //! Returns the view cells.
+    Grid const & grid() const { return grid_; }
+
+    //! Returns the number of cells.
+    int cellCount() const { return grid_.cellsX * grid_.cellsY * grid_.cellsZ; }
+
+    //! Returns the number of objects.
+    size_t objectCount() const { return objectCount_; }
+
+    //! Returns the size of the encoded visibility data in bytes.
+    size_t encodedSize() const { return (offsets_.size() + data_.size()) * sizeof(uint32_t); }
+
+private:
+
+    Grid grid_ = Grid();                // The view cells
+    size_t objectCount_ = 0;            // Number of objects
+    std::vector<uint32_t> offsets_;     // The encoded bitset of cell i is data_[offsets_[i]] ... data_[offsets_[i+1]-1]
+    std::vector<uint32_t> data_;        // Encoded bitsets
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_POTENTIALLYVISIBLESET_H)
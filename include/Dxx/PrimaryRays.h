@@ -0,0 +1,50 @@
+#pragma once
+
+#if !defined(DXX_PRIMARYRAYS_H)
+#define DXX_PRIMARYRAYS_H
+
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+namespace Dxx
+{
+class Camera;
+
+//! Rays through the pixels of a camera's view, in structure-of-arrays form.
+//!
+//! Ray @e i passes through pixel (pixelX[i], pixelY[i]). Its origin is on the near plane and its direction is a unit
+//! vector, both in world space.
+//!
+//! @ingroup	D3dx
+//!
+
+struct PrimaryRays
+{
+    std::vector<float> originX;         //!< Origins
+    std::vector<float> originY;
+    std::vector<float> originZ;
+    std::vector<float> directionX;      //!< Unit directions
+    std::vector<float> directionY;
+    std::vector<float> directionZ;
+    std::vector<uint32_t> pixelX;       //!< The pixel that each ray passes through
+    std::vector<uint32_t> pixelY;
+
+    //! Returns the number of rays.
+    size_t size() const { return directionX.size(); }
+};
+
+//! Generates a ray through each pixel in a rectangle of a camera's view.
+void GeneratePrimaryRays(Camera const &            camera,
+                         int                       viewportWidth,
+                         int                       viewportHeight,
+                         int                       x,
+                         int                       y,
+                         int                       width,
+                         int                       height,
+                         DirectX::XMFLOAT2 const * pJitter,
+                         PrimaryRays &             rays,
+                         int                       tileSize = 8);
+} // namespace Dxx
+
+#endif // !defined(DXX_PRIMARYRAYS_H)
@@ -0,0 +1,43 @@
+#pragma once
+
+#if !defined(DXX_SHADOWCASTERVOLUME_H)
+#define DXX_SHADOWCASTERVOLUME_H
+
+#include "Dxx/Culling.h"
+#include <DirectXMath.h>
+
+namespace Dxx
+{
+class Camera;
+class DirectionalLight;
+class SpotLight;
+
+//! @name	Shadow Caster Culling
+//! @ingroup	Culling
+//!
+//! An object can only cast a shadow into the view frustum if it is inside the volume swept out by the view frustum
+//! moving toward the light. The volume is the convex hull of the frustum's corners and their projections toward the
+//! light, and it is returned as a CullingFrustum so that the casters can be culled with CullBoxes(), CullSpheres(), etc.
+//!
+//! The volume is bounded by the frustum planes that face away from the light, and by the planes through each
+//! silhouette edge of the frustum (as seen from the light) and the light.
+//@{
+
+//! Returns the volume containing the objects that can cast shadows from a directional light into a view frustum.
+CullingFrustum ShadowCasterVolume(Camera const & camera, DirectionalLight const & light);
+
+//! Returns the volume containing the objects that can cast shadows from a spot light into a view frustum.
+CullingFrustum ShadowCasterVolume(Camera const & camera, SpotLight const & light);
+
+//! Returns the volume containing the objects that can cast shadows from a light in the given direction.
+CullingFrustum ShadowCasterVolumeDirectional(DirectX::XMFLOAT4X4 const & viewProjection,
+                                             DirectX::XMFLOAT3 const &   direction);
+
+//! Returns the volume containing the objects that can cast shadows from a light at the given position.
+CullingFrustum ShadowCasterVolumePositional(DirectX::XMFLOAT4X4 const & viewProjection,
+                                            DirectX::XMFLOAT3 const &   position);
+
+//@}
+} // namespace Dxx
+
+#endif // !defined(DXX_SHADOWCASTERVOLUME_H)
@@ -0,0 +1,103 @@
+#pragma once
+
+#if !defined(DXX_SPATIALHASHGRID_H)
+#define DXX_SPATIALHASHGRID_H
+
+#include "Dxx/Culling.h"
+#include <atomic>
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+namespace Dxx
+{
+class Camera;
+
+//! A uniform grid of points stored in a hash table, for finding the points near a position or in a view.
+//!
+//! Space is divided into cubic cells, and only the cells containing points are stored. The cells are stored in an
+//! open-addressed hash table, and the points in each cell are linked together, so inserting a point does not allocate
+//! memory unless the grid needs to grow (which can be avoided by calling reserve()). Points are inserted in parallel
+//! when they are inserted in batches.
+//!
+//! A point's id is the order in which it was inserted, starting at 0. Points cannot be removed individually; instead,
+//! the grid is rebuilt, which is fast.
+//!
+//! @ingroup	Culling
+//!
+
+class SpatialHashGrid
+{
+public:
+
+    //! Constructor.
+    explicit SpatialHashGrid(float cellSize);
+
+    //! Reserves space for the given total number of points.
+    void reserve(size_t count);
+
+    //! Removes all of the points.
+    void clear();
+
+    //! Removes all of the points and inserts an array of points.
+    void build(DirectX::XMFLOAT3 const * pPositions, size_t count, size_t stride = sizeof(DirectX::XMFLOAT3));
+
+    //! Inserts a point and returns its id.
+    uint32_t insert(DirectX::XMFLOAT3 const & position);
+
+    //! Inserts an array of points and returns the id of the first one.
+    uint32_t insert(DirectX::XMFLOAT3 const * pPositions, size_t count, size_t stride = sizeof(DirectX::XMFLOAT3));
+
+    //! Appends the ids of the points inside a sphere.
+    void querySphere(DirectX::XMFLOAT3 const & center, float radius, std::vector<uint32_t> & results) const;
+
+    //! Appends the ids of the points inside a camera's view frustum.
+    void queryFrustum(Camera const & camera, std::vector<uint32_t> & results) const;
+
+    //! Appends the ids of the points inside a culling volume.
+    void queryFrustum(CullingFrustum const & frustum, std::vector<uint32_t> & results) const;
+
+    //! Returns the number of points.
+    size_t size() const { return positions_.size(); }
+
+    //! Returns the position of a point.
+    DirectX::XMFLOAT3 const & position(uint32_t id) const { return positions_[id]; }
+
+    //! Returns the size of a cell.
+    float cellSize() const { return cellSize_; }
+
+private:
+
+    static uint32_t constexpr NONE = ~0u;   // Indicates the end of a list
+
+    // Inserts the points with ids in the range [begin, end) into the hash table (in parallel)
+    void Link(size_t begin, size_t end);
+
+    // Resizes the hash table to hold at least the given number of cells and relinks the points
+    void Grow(size_t cellCount);
+
+    // Returns the slot of a cell in the hash table, or NONE if the cell is empty
+    uint32_t Find(uint64_t key) const;
+
+    // Appends the ids of the points inside a culling volume, checking only the cells in the given range
+    void QueryFrustum(CullingFrustum const &  frustum,
+                      int const               lo[3],
+                      int const               hi[3],
+                      std::vector<uint32_t> & results) const;
+
+    // Calls f(slot, x, y, z) for each non-empty cell in the range, choosing the cheaper of checking each cell in the
+    // range or each slot in the table
+    template <typename Function>
+    void ForEachCell(int const lo[3], int const hi[3], Function f) const;
+
+    float cellSize_;                                    // Size of a cell
+    float invCellSize_;                                 // 1 / cellSize_
+    std::vector<DirectX::XMFLOAT3> positions_;          // Positions of the points
+    std::vector<uint32_t> next_;                        // The next point in the same cell
+    std::vector<std::atomic<uint64_t> > keys_;          // Hash table of cells
+    std::vector<std::atomic<uint32_t> > heads_;         // The first point in each cell in the hash table
+    std::atomic<size_t> cellCount_;                     // Number of non-empty cells
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_SPATIALHASHGRID_H)
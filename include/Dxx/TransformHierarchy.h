@@ -0,0 +1,84 @@
+#pragma once
+
+#if !defined(DXX_TRANSFORMHIERARCHY_H)
+#define DXX_TRANSFORMHIERARCHY_H
+
+#include "Dxx/Frame.h"
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+namespace Dxx
+{
+//! A hierarchy of frames of reference, in which each node's world transformation is its local transformation
+//! followed by its parent's world transformation.
+//!
+//! The nodes are stored in structure-of-arrays form, sorted by depth so that every parent comes before its children,
+//! and the children of each node are consecutive. When a node's local frame changes, it is marked, and update()
+//! recomputes the world transformations of the marked nodes and their descendants one level at a time, with the nodes
+//! of each level computed in parallel. Nodes whose ancestors have not changed are not touched.
+//!
+//! A node's id does not change, but its position in the arrays changes when nodes are added.
+//!
+//! @ingroup	D3dx
+//!
+
+class TransformHierarchy
+{
+public:
+
+    static uint32_t constexpr NONE = ~0u;   //!< Indicates no parent
+
+    //! Constructor.
+    TransformHierarchy();
+
+    //! Reserves space for the given number of nodes.
+    void reserve(size_t count);
+
+    //! Adds a node and returns its id.
+    uint32_t add(Frame const & local, uint32_t parent = NONE);
+
+    //! Sets a node's local frame of reference.
+    void setLocal(uint32_t id, Frame const & local);
+
+    //! Returns a node's local frame of reference.
+    Frame const & local(uint32_t id) const { return locals_[slots_[id]]; }
+
+    //! Returns a node's parent, or NONE if it has none.
+    uint32_t parent(uint32_t id) const;
+
+    //! Returns a node's world transformation, as of the last call to update().
+    DirectX::XMFLOAT4X4 const & world(uint32_t id) const { return worlds_[slots_[id]]; }
+
+    //! Recomputes the world transformations of the nodes that have changed and their descendants.
+    void update();
+
+    //! Returns the number of nodes.
+    size_t size() const { return locals_.size(); }
+
+    //! Returns the number of world transformations recomputed by the last call to update().
+    size_t updateCount() const { return updateCount_; }
+
+private:
+
+    // Sorts the nodes by depth, grouping the children of each node
+    void Sort();
+
+    std::vector<Frame> locals_;                 // Local frames of reference
+    std::vector<DirectX::XMFLOAT4X4> worlds_;   // World transformations
+    std::vector<uint32_t> parents_;             // Position of the parent (or NONE)
+    std::vector<uint32_t> firstChildren_;       // Position of the first child
+    std::vector<uint32_t> childCounts_;         // Number of children
+    std::vector<uint32_t> depths_;              // Depth (a root's depth is 0)
+    std::vector<uint32_t> stamps_;              // Value of stamp_ when the world transformation was last computed
+    std::vector<uint32_t> ids_;                 // Id of the node at each position
+    std::vector<uint32_t> slots_;               // Position of each node
+    std::vector<uint32_t> changed_;             // Ids of the nodes whose local frames have changed
+    std::vector<std::vector<uint32_t> > levels_; // Positions of the nodes to update at each depth (scratch)
+    uint32_t stamp_;                            // Incremented by each call to update()
+    size_t updateCount_;                        // Number of world transformations recomputed by the last update
+    bool sorted_;                               // False if nodes have been added since the last sort
+};
+} // namespace Dxx
+
+#endif // !defined(DXX_TRANSFORMHIERARCHY_H)
@@ -0,0 +1,58 @@
+#pragma once
+
+#if !defined(DXX_TRANSFORMSTREAMS_H)
+#define DXX_TRANSFORMSTREAMS_H
+
+#include <DirectXMath.h>
+
+namespace Dxx
+{
+class Camera;
+class Frame;
+
+//! @name	Transform Streams
+//! @ingroup	D3dx
+//!
+//! These functions transform arrays of vectors. The strides are in bytes and may be larger than the size of the
+//! vectors, so the functions can read and write vertex data in place (the input and output may be the same array if
+//! their strides are the same). Large arrays are split into chunks that are transformed in parallel. If the processor
+//! supports AVX2 and FMA, each chunk is transformed 8 vectors at a time with AVX2. Otherwise, it is transformed with
+//! DirectXMath's SIMD stream functions. The processor is checked once, on first use.
+//@{
+
+//! Transforms points by a frame.
+void TransformPoints(Frame const &             frame,
+                     DirectX::XMFLOAT3 const * pIn,
+                     size_t                    inStride,
+                     size_t                    count,
+                     DirectX::XMFLOAT3 *       pOut,
+                     size_t                    outStride);
+
+//! Transforms directions by a frame, ignoring its translation.
+void TransformDirections(Frame const &             frame,
+                         DirectX::XMFLOAT3 const * pIn,
+                         size_t                    inStride,
+                         size_t                    count,
+                         DirectX::XMFLOAT3 *       pOut,
+                         size_t                    outStride);
+
+//! Transforms normals by a frame, and normalizes them.
+void TransformNormals(Frame const &             frame,
+                      DirectX::XMFLOAT3 const * pIn,
+                      size_t                    inStride,
+                      size_t                    count,
+                      DirectX::XMFLOAT3 *       pOut,
+                      size_t                    outStride);
+
+//! Transforms points by a camera's view-projection matrix into clip space.
+void TransformToClipSpace(Camera const &            camera,
+                          DirectX::XMFLOAT3 const * pIn,
+                          size_t                    inStride,
+                          size_t                    count,
+                          DirectX::XMFLOAT4 *       pOut,
+                          size_t                    outStride);
+
+//@}
+} // namespace Dxx
+
+#endif // !defined(DXX_TRANSFORMSTREAMS_H)